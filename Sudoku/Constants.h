@@ -7,20 +7,37 @@
 #ifndef __CONSTANTS_INCLUDED
 #define __CONSTANTS_INCLUDED
 
-const int numCols = 9;
-const int numRows = 9;
-const int numBoxes = 9;
-const int numHyperBoxes = 4;
+/* The width and height of a box. The game uses 3, i.e. 9x9 puzzles. The puzzle
+ * engine also supports 2 (4x4), 4 (16x16) and 5 (25x25), by defining BOX_SIZE
+ * when compiling. The bit masks used for values are ints, which limits the box
+ * size to five.
+ */
+#ifndef BOX_SIZE
+#define BOX_SIZE 3
+#endif
+
+const int boxSize = BOX_SIZE;
+
+// Hyper Sudokus are only defined for 9x9 puzzles
+const bool hyperSupported = (boxSize == 3);
+
+const int numCols = boxSize * boxSize;
+const int numRows = numCols;
+const int numBoxes = numCols;
+const int numHyperBoxes = hyperSupported ? 4 : 0;
 // Even though there are only four visible hyper-boxes, there are five implicit ones.
-const int numImplicitHyperBoxes = 5;
+const int numImplicitHyperBoxes = hyperSupported ? 5 : 0;
 
-const int numValues = 9;
+const int numValues = numCols;
 const int numCells = numRows * numCols;
 
 const int numBasicConstraintGroups = numCols + numRows + numBoxes;
 const int numExplicitConstraintGroups = numBasicConstraintGroups + numHyperBoxes;
 const int numConstraintGroups = numExplicitConstraintGroups + numImplicitHyperBoxes;
-const int maxConstraintsPerCell = 4;
+// Each cell is in a column, row and box
+const int numBasicConstraintsPerCell = 3;
+// ... and in a Hyper Sudoku also in a (possibly implicit) hyper-box
+const int maxConstraintsPerCell = numBasicConstraintsPerCell + (hyperSupported ? 1 : 0);
 const int constraintGroupSize = numValues;
 
 const int maxBitValue = 1 << (numValues - 1);
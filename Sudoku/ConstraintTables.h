@@ -0,0 +1,86 @@
+/*
+ * Sudoku, a Gamebuino game
+ *
+ * Copyright 2018, Erwin Bonsma
+ */
+
+#ifndef __CONSTRAINT_TABLES_INCLUDED
+#define __CONSTRAINT_TABLES_INCLUDED
+
+#include "Constants.h"
+#include "IndexList.h"
+
+/* The constraint tables are computed at compile time. This way they do not
+ * need initialisation, live in flash instead of RAM, and the compiler can see
+ * their contents.
+ */
+
+// Cell at the given position of the given box
+constexpr int boxCell(int box, int pos) {
+  return (
+    boxSize * (box % boxSize) + boxSize * numCols * (box / boxSize) +
+    pos % boxSize + numCols * (pos / boxSize)
+  );
+}
+
+// The hyper-boxes are only used for 9x9 puzzles, so assume a box size of
+// three.
+
+// Cell at the given position of the given explicit hyper-box (0-3)
+constexpr int hyperBoxCell(int box, int pos) {
+  return (1 + (box % 2) * 4) + (1 + (box / 2) * 4) * numCols + pos % 3 + numCols * (pos / 3);
+}
+
+/* Cell at the given position of the given implicit hyper-box (0-4). The first
+ * four are formed by the cells between the explicit hyper-boxes, in pairs
+ * that are each other's transpose. The last one consists of the cells outside
+ * the rows and columns of the other boxes.
+ */
+constexpr int implicitHyperBoxCell(int box, int pos) {
+  return (
+    (box == 4)
+    ? (pos % 3) * 4 + (pos / 3) * 4 * numCols
+    : (box % 2 == 0)
+      ? (pos % 3) * 4 + (1 + (box / 2) * 4 + pos / 3) * numCols
+      : (1 + (box / 2) * 4 + pos / 3) + (pos % 3) * 4 * numCols
+  );
+}
+
+/* Cell at the given position of the given constraint group. The groups are:
+ * the columns, the rows, the boxes, the explicit hyper-boxes and the implicit
+ * hyper-boxes.
+ */
+constexpr int constraintCell(int group, int pos) {
+  return (
+    (group < numCols)
+    ? group + pos * numCols
+    : (group < numCols + numRows)
+      ? (group - numCols) * numCols + pos
+      : (group < numBasicConstraintGroups)
+        ? boxCell(group - numCols - numRows, pos)
+        : (group < numExplicitConstraintGroups)
+          ? hyperBoxCell(group - numBasicConstraintGroups, pos)
+          : implicitHyperBoxCell(group - numExplicitConstraintGroups, pos)
+  );
+}
+
+template <class Indices> struct ConstraintTableData;
+template <int... Is> struct ConstraintTableData<IndexList<Is...>> {
+  static constexpr int cells[numConstraintGroups][constraintGroupSize] = {
+    constraintCell(Is / constraintGroupSize, Is % constraintGroupSize)...
+  };
+};
+template <int... Is>
+constexpr int ConstraintTableData<IndexList<Is...>>::cells[numConstraintGroups][constraintGroupSize];
+
+typedef ConstraintTableData<
+  MakeIndexList<numConstraintGroups * constraintGroupSize>::type
+> ConstraintTable;
+
+// The cells of each constraint group. The reference is static, as otherwise
+// each unit that includes this would define it.
+static constexpr const int (&constraintCells)[numConstraintGroups][constraintGroupSize] = (
+  ConstraintTable::cells
+);
+
+#endif
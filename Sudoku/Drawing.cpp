@@ -9,6 +9,8 @@
 #include "Drawing.h"
 
 #include "Globals.h"
+#include "IndexList.h"
+#include "Profiling.h"
 #include "Utils.h"
 
 void drawLines(int i) {
@@ -27,7 +29,7 @@ void drawValue(int x, int y, int value) {
 
 int solvedCount;
 
-const uint8_t solveImageData[] = {
+constexpr uint8_t solveImageData[] = {
   74, 9, 1, 0, 1, 0xFF, 1,
   0x00, 0x0a, 0xaa, 0xaa, 0x00, 0x00, 0x00, 0xcc, 0x00, 0x00,
   0xcc, 0x0c, 0xcc, 0xcc, 0xc0, 0xcc, 0x00, 0x00, 0xcc, 0x00,
@@ -66,14 +68,95 @@ const uint8_t solveImageData[] = {
   0xc0, 0x00, 0xbb, 0xbb, 0x00, 0x00, 0xbb, 0xbb, 0x00, 0xbb,
   0x00, 0xbb, 0x0b, 0xbb, 0xbb, 0xb0, 0xaa
 };
-Image solveImage = Image(solveImageData);
+const int solveImageWidth = 74;
+const int solveImageHeight = 9;
+
+// The pixels follow the header, a row at a time. Each byte holds two pixels,
+// the left one in its upper four bits.
+const int solveImageHeaderSize = 7;
+const int solveImageRowSize = solveImageWidth / 2;
+
+// The colors of the solve image. Black must come first.
+const int numSolveColors = 4;
+constexpr ColorIndex solveColors[numSolveColors] = {
+  INDEX_BLACK, INDEX_YELLOW, INDEX_LIGHTGREEN, INDEX_LIGHTBLUE
+};
+
+/* The tables for the solve animation are computed at compile time from the
+ * image, so that they do not need initialisation and live in flash instead of
+ * RAM.
+ */
+
+constexpr int solveImagePixel(int x, int y) {
+  return (
+    solveImageData[solveImageHeaderSize + y * solveImageRowSize + x / 2] >> ((x % 2 == 0) ? 4 : 0)
+  ) & 0xf;
+}
+
+// The index of the color in solveColors, or numSolveColors if it is not there
+constexpr int solveColorIndexOf(int color, int i = 0) {
+  return (
+    (i == numSolveColors || (int)solveColors[i] == color)
+    ? i
+    : solveColorIndexOf(color, i + 1)
+  );
+}
+
+// Checks the pixels from "begin" until "end" in row-major order. It splits
+// the range in halves to limit the recursion depth.
+constexpr bool hasOnlySolveColors(int begin, int end) {
+  return (
+    (end - begin == 1)
+    ? solveColorIndexOf(
+        solveImagePixel(begin % solveImageWidth, begin / solveImageWidth)
+      ) < numSolveColors
+    : (
+        hasOnlySolveColors(begin, (begin + end) / 2) &&
+        hasOnlySolveColors((begin + end) / 2, end)
+      )
+  );
+}
+static_assert(
+  hasOnlySolveColors(0, solveImageWidth * solveImageHeight),
+  "The solve image uses a color that is not in solveColors"
+);
+
+// Column x of the solve image from row y onwards. Each row takes two bits,
+// which index solveColors.
+constexpr uint32_t solveColumn(int x, int y = 0) {
+  return (
+    (y == solveImageHeight)
+    ? 0
+    : (uint32_t)solveColorIndexOf(solveImagePixel(x, y)) << (y * 2) | solveColumn(x, y + 1)
+  );
+}
+
+template <class Indices> struct SolveColumnData;
+template <int... Is> struct SolveColumnData<IndexList<Is...>> {
+  static constexpr uint32_t columns[solveImageWidth] = { solveColumn(Is)... };
+};
+template <int... Is>
+constexpr uint32_t SolveColumnData<IndexList<Is...>>::columns[solveImageWidth];
+
+// The solve image, one entry per column, which is faster to access than the
+// image itself
+constexpr const uint32_t (&solveColumns)[solveImageWidth] = (
+  SolveColumnData<MakeIndexList<solveImageWidth>::type>::columns
+);
+
+constexpr int solveColumnColorIndex(int x, int row) {
+  return (x < 0 || x >= solveImageWidth) ? 0 : (solveColumns[x] >> (row * 2)) & 0x3;
+}
+
+/* The index in solveColors of the color that the given cell has in the given
+ * step of the animation. Columns outside the grid are used for the lights.
+ */
+constexpr int solveColorIndex(int step, int col, int row) {
+  return solveColumnColorIndex(col + step / 4 - 12, row);
+}
 
 ColorIndex solvedColor(int col, int row) {
-  int x = col + solvedCount / 4 - 12;
-  if (x < 0 || x >= 74) {
-    return INDEX_BLACK;
-  }
-  return solveImage.getPixelIndex(x, row);
+  return solveColors[solveColorIndex(solvedCount, col, row)];
 }
 
 //------------------------------------------------------------------------------
@@ -101,42 +184,77 @@ const uint16_t gradientColorsLightGreen[numGradientColors] = {
   0x5c47, 0x64c8, 0x6d69, 0x7dea, 0x866b
 };
 
-Color solveColorForLight(int x, int y) {
-  int col = (x == 0) ? -2 : 9;
-  int row0 = y * 2;
-  ColorIndex color = INDEX_BLACK;
-  int intensity = 0;
+// The gradient for each of the solveColors. Black lights stay off.
+const uint16_t* const solveGradients[numSolveColors] = {
+  NULL, gradientColorsYellow, gradientColorsLightGreen, gradientColorsLightBlue
+};
 
-  for (int i = 0; i < 2; i++) {
-    int intensityDelta = (solvedCount % 4);
-    if (i == 0) {
-      intensityDelta = 4 - intensityDelta;
-    }
-    for (int j = 0; j < 3; j++) {
-      ColorIndex c = solvedColor(col + i, row0 + j);
-      if (c != INDEX_BLACK) {
-        color = c;
-        intensity += intensityDelta;
-      }
-    }
-  }
-  assertTrue(intensity >= 0 && intensity < numGradientColors);
-  if (color == INDEX_YELLOW) {
-    return (Color)gradientColorsYellow[intensity];
-  }
-  if (color == INDEX_LIGHTBLUE) {
-    return (Color)gradientColorsLightBlue[intensity];
-  }
-  if (color == INDEX_LIGHTGREEN) {
-    return (Color)gradientColorsLightGreen[intensity];
-  }
-  return BLACK;
+const int numSolveSteps = 360;
+const int numLights = 8;
+
+/* Each light shows the cells of two columns and three rows next to the grid.
+ * Cell k (0-5) of the light at the given position is in column k / 3. In each
+ * step, the intensity shifts from the first column to the second.
+ */
+constexpr int solveLightCell(int step, int x, int y, int k) {
+  return solveColorIndex(step, ((x == 0) ? -2 : 9) + k / 3, y * 2 + k % 3);
 }
 
+constexpr int solveLightDelta(int step, int k) {
+  return (k / 3 == 0) ? 4 - step % 4 : step % 4;
+}
+
+// The color of the last of cells 0..k that is not black
+constexpr int solveLightColor(int step, int x, int y, int k = 5) {
+  return (
+    (k < 0)
+    ? 0
+    : (solveLightCell(step, x, y, k) != 0)
+      ? solveLightCell(step, x, y, k)
+      : solveLightColor(step, x, y, k - 1)
+  );
+}
+
+// The summed intensity of cells k..5 that are not black
+constexpr int solveLightIntensity(int step, int x, int y, int k = 0) {
+  return (
+    (k == 6)
+    ? 0
+    : ((solveLightCell(step, x, y, k) != 0) ? solveLightDelta(step, k) : 0) +
+      solveLightIntensity(step, x, y, k + 1)
+  );
+}
+static_assert(3 * 4 < numGradientColors, "Light intensity exceeds the gradients");
+
+constexpr uint8_t solveLight(int step, int x, int y) {
+  return (uint8_t)((solveLightColor(step, x, y) << 4) | solveLightIntensity(step, x, y));
+}
+
+// Steps are numbered from one, as solvedCount. Lights are numbered x * 4 + y.
+template <class Indices> struct SolveLightData;
+template <int... Is> struct SolveLightData<IndexList<Is...>> {
+  static constexpr uint8_t lights[numSolveSteps][numLights] = {
+    solveLight(Is / numLights + 1, (Is % numLights) / 4, Is % 4)...
+  };
+};
+template <int... Is>
+constexpr uint8_t SolveLightData<IndexList<Is...>>::lights[numSolveSteps][numLights];
+
+/* The color of each light in each step of the animation. The upper four bits
+ * index solveColors, the lower four bits the gradient.
+ */
+constexpr const uint8_t (&solveLights)[numSolveSteps][numLights] = (
+  SolveLightData<MakeIndexList<numSolveSteps * numLights>::type>::lights
+);
+
 void drawSolveLights() {
+  const uint8_t* lights = solveLights[solvedCount - 1];
+
   for (int x = 0; x < 2; x++) {
     for (int y = 0; y < 4; y++) {
-      gb.lights.drawPixel(x, y, solveColorForLight(x, y));
+      uint8_t light = lights[x * 4 + y];
+      const uint16_t* gradient = solveGradients[light >> 4];
+      gb.lights.drawPixel(x, y, gradient ? (Color)gradient[light & 0xf] : BLACK);
     }
   }
 }
@@ -149,7 +267,36 @@ void drawBlockedLights() {
   }
 }
 
-void draw(Sudoku& sudoku) {
+//------------------------------------------------------------------------------
+
+/* Retained-mode rendering. The display is not cleared each frame. Instead, the
+ * appearance of each cell when it was last drawn is remembered, and only cells
+ * whose appearance changed are redrawn. Everything is redrawn when something
+ * else may have drawn over the puzzle, and during the solve animation, which
+ * changes most cells each frame anyway.
+ */
+
+// The appearance of each cell: its value, text color and background color
+uint16_t drawnCells[numCells];
+
+// The number of frames that should still be redrawn completely
+int numFullRedraws = 1;
+
+uint32_t lastDrawnFrame;
+
+void invalidateDisplay(int numFrames) {
+  if (numFrames > numFullRedraws) {
+    numFullRedraws = numFrames;
+  }
+}
+
+uint16_t cellAppearance(int value, ColorIndex textColor, ColorIndex bgColor) {
+  return value | ((int)textColor << 5) | ((int)bgColor << 10);
+}
+
+void drawGrid() {
+  PROFILE(ProfilePhase::DrawGrid);
+
   gb.display.setColor(DARKGRAY);
   for (int i = 0; i <= numCols; i++) {
     if (i % 3 != 0) {
@@ -160,9 +307,13 @@ void draw(Sudoku& sudoku) {
   for (int i = 0; i <= numCols; i += 3) {
     drawLines(i);
   }
+}
+
+void drawLights(Sudoku& sudoku) {
+  PROFILE(ProfilePhase::DrawLights);
 
   if (sudoku.isSolved()) {
-    solvedCount = 1 + solvedCount % 360;
+    solvedCount = 1 + solvedCount % numSolveSteps;
     drawSolveLights();
   } else {
     solvedCount = 0;
@@ -171,6 +322,11 @@ void draw(Sudoku& sudoku) {
   if (solutionCount == SolutionCount::None) {
     drawBlockedLights();
   }
+}
+
+// Draws the cells that changed, or all when fullRedraw is set
+void drawCells(Sudoku& sudoku, bool fullRedraw) {
+  PROFILE(ProfilePhase::DrawCells);
 
   for (int x = 0; x < numCols; x++) {
     for (int y = 0; y < numRows; y++) {
@@ -188,25 +344,67 @@ void draw(Sudoku& sudoku) {
           bgColor = INDEX_BLUE;
         }
       }
-      if (bgColor != INDEX_BLACK) {
-        gb.display.setColor(bgColor);
-        drawCell(x, y);
-      }
-      if (sudoku.isSet(x, y)) {
+
+      int value = sudoku.getValue(x, y);
+      ColorIndex textColor = INDEX_BLACK;
+      if (value > 0) {
         if (solutionCount == SolutionCount::Multiple) {
-          gb.display.setColor(LIGHTGREEN);
+          textColor = INDEX_LIGHTGREEN;
         }
         else if (solutionCount == SolutionCount::None) {
-          gb.display.setColor(RED);
+          textColor = INDEX_RED;
+        }
+        else if (
+          solutionCount == SolutionCount::Computing ||
+          solutionCount == SolutionCount::Unknown
+        ) {
+          textColor = INDEX_GRAY;
         }
         else if (sudoku.isFixed(x, y)) {
-          gb.display.setColor(WHITE);
+          textColor = INDEX_WHITE;
         }
         else {
-          gb.display.setColor(LIGHTBLUE);
+          textColor = INDEX_LIGHTBLUE;
         }
-        drawValue(x, y, sudoku.getValue(x, y));
       }
+
+      uint16_t appearance = cellAppearance(value, textColor, bgColor);
+      uint16_t& drawn = drawnCells[x + y * numCols];
+      if (!fullRedraw && appearance == drawn) {
+        continue;
+      }
+      drawn = appearance;
+
+      // After a full clear, black backgrounds need not be drawn
+      if (bgColor != INDEX_BLACK || !fullRedraw) {
+        gb.display.setColor(bgColor);
+        drawCell(x, y);
+      }
+      if (value > 0) {
+        gb.display.setColor(textColor);
+        drawValue(x, y, value);
+      }
+    }
+  }
+}
+
+void draw(Sudoku& sudoku) {
+  // Other screens, e.g. the menu, have been shown when frames were skipped
+  if (gb.frameCount != lastDrawnFrame + 1) {
+    invalidateDisplay(1);
+  }
+  lastDrawnFrame = gb.frameCount;
+
+  drawLights(sudoku);
+
+  bool fullRedraw = (numFullRedraws > 0 || solvedCount > 0);
+  if (fullRedraw) {
+    if (numFullRedraws > 0) {
+      numFullRedraws--;
     }
+    gb.display.clear();
+    drawGrid();
   }
+
+  drawCells(sudoku, fullRedraw);
 }
@@ -6,4 +6,12 @@
 
 #include "Sudoku.h"
 
+/* Draws the puzzle. Only the cells that changed since the previous frame are
+ * redrawn, so the display should not be cleared in between.
+ */
 void draw(Sudoku& sudoku);
+
+/* Makes the next frames redraw the puzzle completely. This is needed after
+ * drawing over the puzzle, e.g. by showing a popup.
+ */
+void invalidateDisplay(int numFrames = 1);
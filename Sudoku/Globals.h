@@ -7,6 +7,7 @@
 #include "Sudoku.h"
 #include "Solver.h"
 #include "Stripper.h"
+#include "ConstraintTables.h"
 
 extern int cursorCol;
 extern int cursorRow;
@@ -19,6 +20,3 @@ extern Sudoku sudoku;
 extern Solver solver;
 extern Stripper stripper;
 
-// Constraint tables, implemented in Sudoku.cpp
-extern int constraintCells[numConstraintGroups][constraintGroupSize];
-
@@ -0,0 +1,385 @@
+/*
+ * Sudoku, a Gamebuino game
+ *
+ * Copyright 2018, Erwin Bonsma
+ */
+
+#include <Gamebuino-Meta.h>
+
+#include "Grader.h"
+
+#include "Globals.h"
+#include "Utils.h"
+
+// The score of each use of the techniques. Guessing is scored separately.
+const int techniqueScores[numTechniques] = { 1, 2, 10, 20, 25, 40, 50, 60, 0 };
+
+Grader::Grader(Sudoku& s) : _s(s) {}
+
+void Grader::init() {
+  bool hyper = _s.hyperConstraintsEnabled();
+  _numActiveConstraints = hyper ? numConstraintGroups : numBasicConstraintGroups;
+  _numCellConstraints = hyper ? maxConstraintsPerCell : numBasicConstraintsPerCell;
+
+  int groupValues[numConstraintGroups];
+  for (int i = _numActiveConstraints; --i >= 0; ) {
+    const int* cellIndices = constraintCells[i];
+    int m = 0;
+    for (int j = constraintGroupSize; --j >= 0; ) {
+      m |= _s.cellAt(cellIndices[j]).getBitValue();
+    }
+    groupValues[i] = m;
+  }
+
+  _numUnset = 0;
+  for (int i = numCells; --i >= 0; ) {
+    SudokuCell& cell = _s.cellAt(i);
+    _values[i] = cell.getBitValue();
+    _candidates[i] = 0;
+    if (_values[i] == 0) {
+      int m = maxBitMask;
+      for (int k = _numCellConstraints; --k >= 0; ) {
+        m &= ~groupValues[cell._constraintGroup[k]];
+      }
+      _candidates[i] = m;
+      _numUnset++;
+    }
+  }
+
+  for (int i = numTechniques; --i >= 0; ) {
+    _counts[i] = 0;
+  }
+  _invalid = false;
+}
+
+void Grader::place(int cellIndex, int bit) {
+  _values[cellIndex] = bit;
+  _candidates[cellIndex] = 0;
+  _numUnset--;
+
+  SudokuCell& cell = _s.cellAt(cellIndex);
+  for (int k = _numCellConstraints; --k >= 0; ) {
+    const int* cellIndices = constraintCells[cell._constraintGroup[k]];
+    for (int j = constraintGroupSize; --j >= 0; ) {
+      _candidates[cellIndices[j]] &= ~bit;
+    }
+  }
+}
+
+bool Grader::eliminate(int cellIndex, int mask) {
+  if ((_candidates[cellIndex] & mask) == 0) {
+    return false;
+  }
+
+  _candidates[cellIndex] &= ~mask;
+  return true;
+}
+
+int Grader::candidatePositions(int groupIndex, int bit) {
+  const int* cellIndices = constraintCells[groupIndex];
+  int positions = 0;
+
+  for (int j = constraintGroupSize; --j >= 0; ) {
+    if ((_candidates[cellIndices[j]] & bit) != 0) {
+      positions |= 1 << j;
+    }
+  }
+
+  return positions;
+}
+
+bool Grader::inGroup(int cellIndex, int groupIndex) {
+  SudokuCell& cell = _s.cellAt(cellIndex);
+  for (int k = _numCellConstraints; --k >= 0; ) {
+    if (cell._constraintGroup[k] == groupIndex) {
+      return true;
+    }
+  }
+  return false;
+}
+
+bool Grader::applyNakedSingles() {
+  int num = 0;
+
+  for (int i = 0; i < numCells; i++) {
+    if (_values[i] == 0) {
+      int m = _candidates[i];
+      if (m == 0) {
+        _invalid = true;
+        return false;
+      }
+      // Next evaluates to zero if only one bit was set
+      if ((m & (m - 1)) == 0) {
+        place(i, m);
+        num++;
+      }
+    }
+  }
+
+  _counts[(int)Technique::NakedSingle] += num;
+  return num > 0;
+}
+
+bool Grader::applyHiddenSingles() {
+  int num = 0;
+
+  for (int i = 0; i < _numActiveConstraints; i++) {
+    const int* cellIndices = constraintCells[i];
+    int placed = 0;
+    for (int j = constraintGroupSize; --j >= 0; ) {
+      placed |= _values[cellIndices[j]];
+    }
+
+    for (int bit = 1; bit <= maxBitValue; bit <<= 1) {
+      if ((placed & bit) != 0) {
+        continue;
+      }
+
+      int positions = candidatePositions(i, bit);
+      if (positions == 0) {
+        _invalid = true;
+        return false;
+      }
+      if ((positions & (positions - 1)) == 0) {
+        place(cellIndices[bitToValue(positions) - 1], bit);
+        num++;
+      }
+    }
+  }
+
+  _counts[(int)Technique::HiddenSingle] += num;
+  return num > 0;
+}
+
+bool Grader::applyLockedCandidates() {
+  for (int i = 0; i < _numActiveConstraints; i++) {
+    const int* cellIndices = constraintCells[i];
+
+    for (int bit = 1; bit <= maxBitValue; bit <<= 1) {
+      int positions = candidatePositions(i, bit);
+      if ((positions & (positions - 1)) == 0) {
+        // Zero or one position. This is a single
+        continue;
+      }
+
+      // Check if all positions share another group
+      SudokuCell& first = _s.cellAt(cellIndices[bitToValue(positions) - 1]);
+      for (int k = _numCellConstraints; --k >= 0; ) {
+        int otherIndex = first._constraintGroup[k];
+        if (otherIndex == i) {
+          continue;
+        }
+
+        bool shared = true;
+        for (int j = constraintGroupSize; --j >= 0 && shared; ) {
+          if ((positions & (1 << j)) != 0) {
+            shared = (_s.cellAt(cellIndices[j])._constraintGroup[k] == otherIndex);
+          }
+        }
+        if (!shared) {
+          continue;
+        }
+
+        // The value must go in the intersection, so eliminate it from the
+        // rest of the other group
+        const int* otherIndices = constraintCells[otherIndex];
+        bool progress = false;
+        for (int j = constraintGroupSize; --j >= 0; ) {
+          if (!inGroup(otherIndices[j], i)) {
+            progress |= eliminate(otherIndices[j], bit);
+          }
+        }
+        if (progress) {
+          _counts[(int)Technique::LockedCandidates]++;
+          return true;
+        }
+      }
+    }
+  }
+
+  return false;
+}
+
+bool Grader::applyNakedSubset(int size) {
+  for (int i = 0; i < _numActiveConstraints; i++) {
+    const int* cellIndices = constraintCells[i];
+
+    // Candidate members: unset cells with at most "size" candidates
+    int members[constraintGroupSize];
+    int n = 0;
+    for (int j = 0; j < constraintGroupSize; j++) {
+      int m = _candidates[cellIndices[j]];
+      if (m != 0 && countBits(m) <= size) {
+        members[n++] = j;
+      }
+    }
+
+    for (int a = 0; a < n; a++) {
+      for (int b = a + 1; b < n; b++) {
+        // For pairs, c equals b
+        int cEnd = (size == 3) ? n : b + 1;
+        for (int c = (size == 3) ? b + 1 : b; c < cEnd; c++) {
+          int values = (
+            _candidates[cellIndices[members[a]]] |
+            _candidates[cellIndices[members[b]]] |
+            _candidates[cellIndices[members[c]]]
+          );
+          if (countBits(values) != size) {
+            continue;
+          }
+
+          bool progress = false;
+          for (int j = constraintGroupSize; --j >= 0; ) {
+            if (j != members[a] && j != members[b] && j != members[c]) {
+              progress |= eliminate(cellIndices[j], values);
+            }
+          }
+          if (progress) {
+            Technique t = (size == 2) ? Technique::NakedPair : Technique::NakedTriple;
+            _counts[(int)t]++;
+            return true;
+          }
+        }
+      }
+    }
+  }
+
+  return false;
+}
+
+bool Grader::applyHiddenSubset(int size) {
+  for (int i = 0; i < _numActiveConstraints; i++) {
+    const int* cellIndices = constraintCells[i];
+
+    // Candidate members: values with at most "size" positions
+    int members[numValues];
+    int positions[numValues];
+    int n = 0;
+    for (int bit = 1; bit <= maxBitValue; bit <<= 1) {
+      int p = candidatePositions(i, bit);
+      if (p != 0 && countBits(p) <= size) {
+        members[n] = bit;
+        positions[n++] = p;
+      }
+    }
+
+    for (int a = 0; a < n; a++) {
+      for (int b = a + 1; b < n; b++) {
+        // For pairs, c equals b
+        int cEnd = (size == 3) ? n : b + 1;
+        for (int c = (size == 3) ? b + 1 : b; c < cEnd; c++) {
+          int cells = positions[a] | positions[b] | positions[c];
+          if (countBits(cells) != size) {
+            continue;
+          }
+
+          int others = maxBitMask & ~(members[a] | members[b] | members[c]);
+          bool progress = false;
+          for (int j = constraintGroupSize; --j >= 0; ) {
+            if ((cells & (1 << j)) != 0) {
+              progress |= eliminate(cellIndices[j], others);
+            }
+          }
+          if (progress) {
+            Technique t = (size == 2) ? Technique::HiddenPair : Technique::HiddenTriple;
+            _counts[(int)t]++;
+            return true;
+          }
+        }
+      }
+    }
+  }
+
+  return false;
+}
+
+bool Grader::applyXWing() {
+  // First with rows as base and columns as cover, then the other way around.
+  // The position of a cell in a row is its column, and vice versa.
+  for (int rowBased = 1; rowBased >= 0; rowBased--) {
+    int baseStart = rowBased ? numCols : 0;
+    int coverStart = rowBased ? 0 : numCols;
+
+    for (int bit = 1; bit <= maxBitValue; bit <<= 1) {
+      for (int l1 = 0; l1 < numRows; l1++) {
+        int p = candidatePositions(baseStart + l1, bit);
+        if (countBits(p) != 2) {
+          continue;
+        }
+
+        for (int l2 = l1 + 1; l2 < numRows; l2++) {
+          if (candidatePositions(baseStart + l2, bit) != p) {
+            continue;
+          }
+
+          // The value is in the two cover lines at l1 and l2. Eliminate it from
+          // the rest of these lines.
+          bool progress = false;
+          for (int j = constraintGroupSize; --j >= 0; ) {
+            if ((p & (1 << j)) != 0) {
+              const int* cellIndices = constraintCells[coverStart + j];
+              for (int l = constraintGroupSize; --l >= 0; ) {
+                if (l != l1 && l != l2) {
+                  progress |= eliminate(cellIndices[l], bit);
+                }
+              }
+            }
+          }
+          if (progress) {
+            _counts[(int)Technique::XWing]++;
+            return true;
+          }
+        }
+      }
+    }
+  }
+
+  return false;
+}
+
+bool Grader::applyTechnique(Technique technique) {
+  switch (technique) {
+    case Technique::NakedSingle: return applyNakedSingles();
+    case Technique::HiddenSingle: return applyHiddenSingles();
+    case Technique::LockedCandidates: return applyLockedCandidates();
+    case Technique::NakedPair: return applyNakedSubset(2);
+    case Technique::HiddenPair: return applyHiddenSubset(2);
+    case Technique::NakedTriple: return applyNakedSubset(3);
+    case Technique::HiddenTriple: return applyHiddenSubset(3);
+    case Technique::XWing: return applyXWing();
+    default: return false;
+  }
+}
+
+int Grader::grade() {
+  init();
+
+  while (_numUnset > 0 && !_invalid) {
+    // Apply the easiest technique that makes progress
+    int i = 0;
+    while (i < (int)Technique::Guess && !applyTechnique((Technique)i) && !_invalid) {
+      i++;
+    }
+    if (i == (int)Technique::Guess) {
+      break;
+    }
+  }
+
+  _score = 0;
+  for (int i = 0; i < numTechniques; i++) {
+    _score += _counts[i] * techniqueScores[i];
+  }
+  if (_numUnset > 0) {
+    // Also when the puzzle turned out to be invalid
+    _counts[(int)Technique::Guess] = 1;
+    _score += guessScore;
+  }
+
+  return _score;
+}
+
+Technique Grader::hardestTechnique() {
+  int i = numTechniques;
+  while (--i > 0 && _counts[i] == 0);
+  return (Technique)i;
+}
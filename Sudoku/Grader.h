@@ -0,0 +1,134 @@
+/*
+ * Sudoku, a Gamebuino game
+ *
+ * Copyright 2018, Erwin Bonsma
+ */
+
+#ifndef __GRADER_INCLUDED
+#define __GRADER_INCLUDED
+
+#include "Sudoku.h"
+
+//------------------------------------------------------------------------------
+
+// The solving techniques used by the grader, from easiest to hardest
+enum class Technique : int {
+  // A cell with only one candidate value left
+  NakedSingle,
+  // A value with only one possible cell left in a group
+  HiddenSingle,
+  // A value in a group that is confined to its intersection with another group
+  LockedCandidates,
+  // Two cells in a group with only the same two candidates
+  NakedPair,
+  // Two values in a group that only fit in the same two cells
+  HiddenPair,
+  NakedTriple,
+  HiddenTriple,
+  // A value that fits in the same two columns of two rows (or vice versa)
+  XWing,
+  // The techniques did not suffice. Solving requires trial and error
+  Guess
+};
+
+const int numTechniques = (int)Technique::Guess + 1;
+
+// The minimum score of a puzzle that requires guessing
+const int guessScore = 1000;
+
+// Higher than any score
+const int unboundedScore = 0x7fffffff;
+
+// A range of scores, including both bounds
+struct DifficultyBand {
+  int minScore;
+  int maxScore;
+
+  bool contains(int score) const { return score >= minScore && score <= maxScore; }
+};
+
+const DifficultyBand anyDifficulty = { 0, unboundedScore };
+
+//------------------------------------------------------------------------------
+
+/* Rates the difficulty of a puzzle by solving it the way a person would. It
+ * keeps its own grid of candidates, and repeatedly applies the easiest
+ * technique that makes progress. It records how often each technique was
+ * needed and returns a score based on that.
+ *
+ * It does not modify the puzzle it grades.
+ */
+class Grader {
+
+  // The puzzle to grade
+  Sudoku& _s;
+
+  // The (bit) value of each cell, zero when not yet set
+  int _values[numCells];
+
+  // The candidate values of each unset cell
+  int _candidates[numCells];
+
+  int _numUnset;
+
+  // The number of constraint groups that apply, for the grid and per cell
+  int _numActiveConstraints;
+  int _numCellConstraints;
+
+  // Set when the candidates show that the puzzle has no solution
+  bool _invalid;
+
+  // How often each technique was applied
+  int _counts[numTechniques];
+
+  int _score;
+
+  // Sets the cell and removes its value from the candidates of its peers
+  void place(int cellIndex, int bit);
+
+  // Removes the given values from the candidates of the cell. Returns true if
+  // any were removed.
+  bool eliminate(int cellIndex, int mask);
+
+  // The positions in the group where the value is a candidate, a bit each
+  int candidatePositions(int groupIndex, int bit);
+
+  // Returns true if the cell is part of the given group
+  bool inGroup(int cellIndex, int groupIndex);
+
+  // The techniques. Each returns true when it made progress.
+  bool applyNakedSingles();
+  bool applyHiddenSingles();
+  bool applyLockedCandidates();
+  bool applyNakedSubset(int size);
+  bool applyHiddenSubset(int size);
+  bool applyXWing();
+
+  bool applyTechnique(Technique technique);
+
+  void init();
+
+public:
+  Grader(Sudoku& s);
+
+  Sudoku& sudoku() { return _s; }
+
+  /* Grades the puzzle. Returns its score. The easiest puzzles, that only need
+   * naked singles, score the number of empty cells. Harder techniques add more
+   * per use. When guessing is needed, the score is at least guessScore.
+   */
+  int grade();
+
+  int score() { return _score; }
+
+  // Returns true if the puzzle was solved without guessing
+  bool isSolved() { return _numUnset == 0; }
+
+  // The number of times the technique was applied
+  int count(Technique technique) { return _counts[(int)technique]; }
+
+  // The hardest technique that was needed
+  Technique hardestTechnique();
+};
+
+#endif
@@ -0,0 +1,28 @@
+/*
+ * Sudoku, a Gamebuino game
+ *
+ * Copyright 2018, Erwin Bonsma
+ */
+
+#ifndef __INDEX_LIST_INCLUDED
+#define __INDEX_LIST_INCLUDED
+
+// Compile-time list of indices, for expanding a constexpr function into a table
+template <int... Is> struct IndexList {};
+
+template <class A, class B> struct ConcatIndexLists;
+template <int... As, int... Bs>
+struct ConcatIndexLists<IndexList<As...>, IndexList<Bs...>> {
+  typedef IndexList<As..., ((int)sizeof...(As) + Bs)...> type;
+};
+
+// Builds the list 0..N-1. It splits in halves to limit the template depth.
+template <int N> struct MakeIndexList {
+  typedef typename ConcatIndexLists<
+    typename MakeIndexList<N / 2>::type, typename MakeIndexList<N - N / 2>::type
+  >::type type;
+};
+template <> struct MakeIndexList<0> { typedef IndexList<> type; };
+template <> struct MakeIndexList<1> { typedef IndexList<0> type; };
+
+#endif
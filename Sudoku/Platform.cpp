@@ -0,0 +1,41 @@
+/*
+ * Sudoku, a Gamebuino game
+ *
+ * Copyright 2018, Erwin Bonsma
+ */
+
+#include <Gamebuino-Meta.h>
+
+#include "Utils.h"
+
+void initDebugLog() {
+  SerialUSB.begin(9600);
+  while (!SerialUSB);
+}
+
+uint32_t timeMicros() {
+  return micros();
+}
+
+void assertFailed(const char *function, const char *file, int lineNo, const char *expression) {
+  if (SerialUSB) {
+    SerialUSB.println("=== ASSERT FAILED ===");
+    SerialUSB.println(function);
+    SerialUSB.println(file);
+    SerialUSB.println(lineNo, DEC);
+    SerialUSB.println(expression);
+    SerialUSB.flush();
+  }
+
+  while (1) {
+    if (gb.update()) {
+      gb.display.clear();
+      gb.display.setColor(RED);
+      gb.display.println("Assert failed:");
+      gb.display.println(function);
+      gb.display.println(file);
+      gb.display.println(lineNo, DEC);
+      gb.display.println(expression);
+    }
+  }
+}
@@ -0,0 +1,123 @@
+/*
+ * Sudoku, a Gamebuino game
+ *
+ * Copyright 2018, Erwin Bonsma
+ */
+
+#include <Gamebuino-Meta.h>
+
+#include "Profiling.h"
+
+#ifdef PROFILING
+
+const int numProfiledFrames = 32;
+
+// The frame rate is 25 frames per second
+const uint32_t frameDeadlineMicros = 40000;
+
+const char* phaseNames[numProfilePhases] = {
+  "grid", "lights", "cells", "update", "solver", "generate", "frame"
+};
+
+// Ring buffer with the time spent per phase in each frame. Times are capped at
+// 65535 micros.
+uint16_t phaseTimes[numProfiledFrames][numProfilePhases];
+int frameIndex = 0;
+uint32_t frameStart;
+
+// Statistics of the last completed buffer, for the overlay
+uint32_t avgFrameTime;
+uint32_t maxFrameTime;
+int numDeadlineMisses;
+
+void initProfiling() {
+  // Do not wait for a connection, so that the game also runs without one
+  SerialUSB.begin(9600);
+}
+
+void recordPhaseTime(ProfilePhase phase, uint32_t micros) {
+  // Phases can occur more than once per frame
+  uint32_t total = phaseTimes[frameIndex][(int)phase] + micros;
+  phaseTimes[frameIndex][(int)phase] = (total < 0xffff) ? total : 0xffff;
+}
+
+void startProfiledFrame() {
+  for (int i = 0; i < numProfilePhases; i++) {
+    phaseTimes[frameIndex][i] = 0;
+  }
+  frameStart = timeMicros();
+}
+
+void dumpProfile() {
+  if (!SerialUSB) {
+    return;
+  }
+
+  SerialUSB.printf("phase       min     avg     max (us)\n");
+  for (int i = 0; i < numProfilePhases; i++) {
+    uint32_t minTime = 0xffff, maxTime = 0, sum = 0;
+    for (int j = 0; j < numProfiledFrames; j++) {
+      uint32_t t = phaseTimes[j][i];
+      minTime = (t < minTime) ? t : minTime;
+      maxTime = (t > maxTime) ? t : maxTime;
+      sum += t;
+    }
+    SerialUSB.printf(
+      "%-8s %6d  %6d  %6d\n",
+      phaseNames[i], (int)minTime, (int)(sum / numProfiledFrames), (int)maxTime
+    );
+  }
+  SerialUSB.printf(
+    "%d of %d frames missed the deadline\n", numDeadlineMisses, numProfiledFrames
+  );
+}
+
+void updateFrameStatistics() {
+  uint32_t sum = 0;
+  maxFrameTime = 0;
+  numDeadlineMisses = 0;
+
+  for (int j = 0; j < numProfiledFrames; j++) {
+    uint32_t t = phaseTimes[j][(int)ProfilePhase::Frame];
+    sum += t;
+    if (t > maxFrameTime) {
+      maxFrameTime = t;
+    }
+    if (t > frameDeadlineMicros) {
+      numDeadlineMisses++;
+    }
+  }
+  avgFrameTime = sum / numProfiledFrames;
+}
+
+void endProfiledFrame() {
+  recordPhaseTime(ProfilePhase::Frame, timeMicros() - frameStart);
+
+  frameIndex++;
+  if (frameIndex == numProfiledFrames) {
+    updateFrameStatistics();
+    dumpProfile();
+    frameIndex = 0;
+  }
+}
+
+// Prints a number of at most two digits, so that it fits in the margin
+void printStatistic(int y, uint32_t value) {
+  gb.display.setCursor(72, y);
+  gb.display.print((int)(value < 99 ? value : 99));
+}
+
+void drawProfilingOverlay() {
+  // The overlay is drawn in the right margin, so that it does not cover the
+  // puzzle, which is not redrawn each frame
+  gb.display.setColor(BLACK);
+  gb.display.fillRect(72, 0, 8, 64);
+
+  gb.display.setColor(WHITE);
+  printStatistic(1, avgFrameTime / 1000);
+  printStatistic(8, maxFrameTime / 1000);
+  gb.display.setColor(numDeadlineMisses > 0 ? RED : WHITE);
+  printStatistic(15, numDeadlineMisses);
+}
+
+#endif
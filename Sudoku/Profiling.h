@@ -0,0 +1,79 @@
+/*
+ * Sudoku, a Gamebuino game
+ *
+ * Copyright 2018, Erwin Bonsma
+ */
+
+#ifndef __PROFILING_INCLUDED
+#define __PROFILING_INCLUDED
+
+#include <stdint.h>
+
+#include "Utils.h"
+
+/* Frame profiling, which is enabled by defining PROFILING in Utils.h.
+ *
+ * The time spent in each phase is recorded per frame in a ring buffer. Each
+ * time the buffer is full, the minimum, average and maximum per phase and the
+ * number of frames that missed their deadline are written to the serial port.
+ * The average and maximum frame time (in ms) and the number of deadline misses
+ * are also shown in an overlay in the right margin of the screen.
+ *
+ * When disabled, the PROFILE macro and the functions compile to nothing.
+ */
+
+enum class ProfilePhase : int {
+  DrawGrid,
+  DrawLights,
+  DrawCells,
+  // Handling of input. When the player edits a puzzle, this only restarts
+  // counting its solutions.
+  Update,
+  // Counting the solutions of an edited puzzle, a step each frame, by
+  // updateSolutionCount(). It is called from loop(), after Update.
+  Solver,
+  // Puzzle generation, in the foreground or for the cache
+  Generation,
+  // The entire frame, excluding waiting for the next one
+  Frame
+};
+const int numProfilePhases = 7;
+
+#ifdef PROFILING
+
+void recordPhaseTime(ProfilePhase phase, uint32_t micros);
+
+// Measures the time until the end of the enclosing scope
+class ProfileScope {
+  ProfilePhase _phase;
+  uint32_t _start;
+
+public:
+  ProfileScope(ProfilePhase phase) : _phase(phase), _start(timeMicros()) {}
+  ~ProfileScope() { recordPhaseTime(_phase, timeMicros() - _start); }
+};
+
+#define PROFILE_CONCAT(a, b) a ## b
+#define PROFILE_NAME(line) PROFILE_CONCAT(profileScope, line)
+#define PROFILE(phase) ProfileScope PROFILE_NAME(__LINE__)(phase)
+
+void initProfiling();
+
+// Should be invoked at the start and end of each frame
+void startProfiledFrame();
+void endProfiledFrame();
+
+void drawProfilingOverlay();
+
+#else
+
+#define PROFILE(phase)
+
+inline void initProfiling() {}
+inline void startProfiledFrame() {}
+inline void endProfiledFrame() {}
+inline void drawProfilingOverlay() {}
+
+#endif
+
+#endif
@@ -4,4 +4,7 @@
  * Copyright 2018, Erwin Bonsma
  */
 
+void drawPuzzleGenerationProgress(int numSteps, int maxSteps);
+
+// Draws the progress and updates the screen, for use during blocking generation
 void signalPuzzleGenerationProgress(int numSteps, int maxSteps);
@@ -0,0 +1,82 @@
+/*
+ * Sudoku, a Gamebuino game
+ *
+ * Copyright 2018, Erwin Bonsma
+ */
+
+#include <Gamebuino-Meta.h>
+
+#include "PuzzleCache.h"
+
+#include "Globals.h"
+#include "Profiling.h"
+#include "PuzzleGenerator.h"
+#include "Store.h"
+#include "Utils.h"
+
+// The time in each frame that can be spent on generating puzzles. A frame
+// lasts 40 ms, most of which is still available after drawing and updating.
+const uint32_t cacheBudgetMicros = 15000;
+
+// The puzzle that is being generated, with its own solver and stripper so that
+// generating it does not affect the puzzle that is being played
+Sudoku cacheSudoku;
+Solver cacheSolver(cacheSudoku);
+Stripper cacheStripper(cacheSudoku, cacheSolver);
+PuzzleGenerator cacheGenerator(cacheSudoku, cacheSolver, cacheStripper);
+
+// Tracks which save blocks hold a generated puzzle, so that these do not need
+// to be checked each frame
+bool isCached[2];
+
+int cacheIndex(bool hyper) {
+  return hyper ? 1 : 0;
+}
+
+void initPuzzleCache() {
+  cacheSudoku.init();
+  cacheSolver.seedRandom(rand());
+
+  isCached[0] = hasGeneratedPuzzle(false);
+  isCached[1] = hasGeneratedPuzzle(true);
+}
+
+void updatePuzzleCache() {
+  PROFILE(ProfilePhase::Generation);
+
+  if (!cacheGenerator.isBusy()) {
+    // The solver may still be searching for others (see suspendPuzzleCache)
+    cacheSolver.cancel();
+
+    // First generate a puzzle of the type that is being played
+    bool hyper = sudoku.hyperConstraintsEnabled();
+    if (isCached[cacheIndex(hyper)]) {
+      hyper = !hyper;
+      if (isCached[cacheIndex(hyper)]) {
+        return;
+      }
+    }
+    cacheGenerator.start(hyper);
+  }
+
+  if (cacheGenerator.step(cacheBudgetMicros)) {
+    cacheSudoku.fixValues();
+    storeGeneratedPuzzle(cacheSudoku);
+
+    // Also when storing failed, as retrying is unlikely to help. A new puzzle
+    // is then generated in the foreground instead.
+    isCached[cacheIndex(cacheSudoku.hyperConstraintsEnabled())] = true;
+  }
+}
+
+Solver& suspendPuzzleCache() {
+  cacheGenerator.cancel();
+
+  return cacheSolver;
+}
+
+bool takeCachedPuzzle() {
+  isCached[cacheIndex(sudoku.hyperConstraintsEnabled())] = false;
+
+  return loadGeneratedPuzzle();
+}
@@ -0,0 +1,32 @@
+/*
+ * Sudoku, a Gamebuino game
+ *
+ * Copyright 2018, Erwin Bonsma
+ */
+
+#include "Solver.h"
+
+/* Background generation of puzzles. While the player is busy, the next puzzle
+ * is generated in small steps, and stored in a save block once it is ready.
+ * Starting a new puzzle then only requires loading it.
+ */
+
+// Should be called once, after the random generator has been seeded.
+void initPuzzleCache();
+
+/* Continues generating a puzzle for as long as the time budget of the current
+ * frame allows. It does not draw anything.
+ */
+void updatePuzzleCache();
+
+/* Makes the cached puzzle of the current type the active puzzle. Returns false
+ * if there is none yet, in which case a puzzle needs to be generated.
+ */
+bool takeCachedPuzzle();
+
+/* Suspends caching until updatePuzzleCache() is invoked again, so that the
+ * cache's solver can be used for other searches meanwhile. It is returned. A
+ * puzzle that was being generated is discarded. It can be invoked each frame,
+ * as it leaves searches of others alone.
+ */
+Solver& suspendPuzzleCache();
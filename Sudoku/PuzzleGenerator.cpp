@@ -0,0 +1,93 @@
+/*
+ * Sudoku, a Gamebuino game
+ *
+ * Copyright 2018, Erwin Bonsma
+ */
+
+#include <Gamebuino-Meta.h>
+
+#include "PuzzleGenerator.h"
+
+#include "Utils.h"
+
+PuzzleGenerator::PuzzleGenerator(Sudoku& sudoku, Solver& solver, Stripper& stripper)
+  : _s(sudoku), _solver(solver), _stripper(stripper), _phase(GeneratorPhase::Idle) {
+
+  assertTrue( &(_solver.sudoku()) == &_s );
+}
+
+void PuzzleGenerator::startAttempt(bool hyperConstraints) {
+  _s.reset(hyperConstraints);
+  _solver.startRandomSolve();
+  _phase = GeneratorPhase::RandomSolve;
+}
+
+void PuzzleGenerator::start(bool hyperConstraints) {
+  assertTrue(!isBusy());
+  startAttempt(hyperConstraints);
+}
+
+bool PuzzleGenerator::step(uint32_t budgetMicros) {
+  uint32_t startTime = timeMicros();
+
+  while (true) {
+    // Checked first, so that a puzzle completed with the last of the budget is
+    // still reported as ready
+    if (_phase == GeneratorPhase::Done) {
+      return true;
+    }
+
+    // The budget that remains for this step, if any
+    uint32_t budget = 0;
+    if (budgetMicros != 0) {
+      uint32_t elapsed = timeMicros() - startTime;
+      if (elapsed >= budgetMicros) {
+        return false;
+      }
+      budget = budgetMicros - elapsed;
+    }
+
+    switch (_phase) {
+      case GeneratorPhase::RandomSolve:
+        if (!_solver.step(budget)) {
+          return false;
+        }
+        assertTrue(_solver.numSolutionsFound() == 1);
+        _stripper.startRandomStrip();
+        _phase = GeneratorPhase::Strip;
+        break;
+
+      case GeneratorPhase::Strip:
+        if (_stripper.stripStep(budget)) {
+          if (_stripper.isWithinBand()) {
+            _phase = GeneratorPhase::Done;
+          } else {
+            startAttempt(_s.hyperConstraintsEnabled());
+          }
+        }
+        break;
+
+      default:
+        return false;
+    }
+  }
+}
+
+void PuzzleGenerator::cancel() {
+  if (isBusy()) {
+    _solver.cancel();
+  }
+  _phase = GeneratorPhase::Idle;
+}
+
+int PuzzleGenerator::progress(int maxSteps) {
+  if (_phase == GeneratorPhase::Done) {
+    return maxSteps;
+  }
+  if (_phase != GeneratorPhase::Strip || _stripper.phase() != StripPhase::Strip2) {
+    return 0;
+  }
+
+  // The first phase and the solve are quick compared to the second phase
+  return maxSteps * _stripper.numClearAttempts() / (_stripper.numFilledAtStart() + 1);
+}
@@ -0,0 +1,71 @@
+/*
+ * Sudoku, a Gamebuino game
+ *
+ * Copyright 2018, Erwin Bonsma
+ */
+
+#ifndef __PUZZLE_GENERATOR_INCLUDED
+#define __PUZZLE_GENERATOR_INCLUDED
+
+#include "Solver.h"
+#include "Stripper.h"
+#include "Sudoku.h"
+
+//------------------------------------------------------------------------------
+
+enum class GeneratorPhase : int {
+  // No puzzle is being generated
+  Idle,
+  // The solver is creating a random solution
+  RandomSolve,
+  // The stripper is clearing values from the solution
+  Strip,
+  // The puzzle is ready
+  Done
+};
+
+//------------------------------------------------------------------------------
+
+/* Generates puzzles in steps of bounded duration, so that generation can be
+ * spread over multiple frames. It runs the same pipeline as a random solve
+ * followed by a random strip, and gives the same puzzles for the same seed.
+ * Puzzles that end up outside the stripper's difficulty band are discarded,
+ * after which generation starts over.
+ */
+class PuzzleGenerator {
+  Sudoku& _s;
+  Solver& _solver;
+  Stripper& _stripper;
+
+  GeneratorPhase _phase;
+
+  void startAttempt(bool hyperConstraints);
+
+public:
+  PuzzleGenerator(Sudoku& sudoku, Solver& solver, Stripper& stripper);
+
+  // Starts generating a puzzle of the given type. It resets the puzzle.
+  void start(bool hyperConstraints);
+
+  /* Continues generating until the puzzle is ready or the given time has
+   * been spent. Returns true when the puzzle is ready. A budget of zero means
+   * that there is no limit.
+   */
+  bool step(uint32_t budgetMicros);
+
+  /* Abandons the puzzle that is being generated, if any. The solver is only
+   * cancelled when it is searching for the generator, so that it can be used
+   * for other searches once the generator is idle.
+   */
+  void cancel();
+
+  bool isBusy() {
+    return _phase == GeneratorPhase::RandomSolve || _phase == GeneratorPhase::Strip;
+  }
+  GeneratorPhase phase() { return _phase; }
+
+  // The progress of the current attempt, from 0 to maxSteps
+  int progress(int maxSteps);
+};
+
+#endif
@@ -0,0 +1,102 @@
+/*
+ * Sudoku, a Gamebuino game
+ *
+ * Copyright 2018, Erwin Bonsma
+ */
+
+#include <Gamebuino-Meta.h>
+
+#include "SolutionTracker.h"
+
+#include "Utils.h"
+
+SolutionTracker::SolutionTracker(Sudoku& puzzle)
+  : _puzzle(puzzle), _numSolutions(0), _hyper(false), _restart(false),
+    _solutionCount(SolutionCount::Computing) {}
+
+bool SolutionTracker::isConsistent(int solutionIndex) {
+  const int* solution = _solutions[solutionIndex];
+
+  for (int i = 0; i < numCells; i++) {
+    int bit = _puzzle.cellAt(i).getBitValue();
+    if (bit != 0 && bit != solution[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+int SolutionTracker::numConsistentSolutions() {
+  if (_hyper != _puzzle.hyperConstraintsEnabled()) {
+    // The solutions need not satisfy the constraints of the other type
+    return 0;
+  }
+
+  int numConsistent = 0;
+  for (int i = 0; i < _numSolutions; i++) {
+    if (isConsistent(i)) {
+      if (i != numConsistent) {
+        for (int j = 0; j < numCells; j++) {
+          int tmp = _solutions[i][j];
+          _solutions[i][j] = _solutions[numConsistent][j];
+          _solutions[numConsistent][j] = tmp;
+        }
+      }
+      numConsistent++;
+    }
+  }
+  return numConsistent;
+}
+
+bool SolutionTracker::startSearch(Solver& solver) {
+  _numSolutions = numConsistentSolutions();
+  if (_numSolutions == maxTrackedSolutions) {
+    _solutionCount = SolutionCount::Multiple;
+    return true;
+  }
+
+  _hyper = _puzzle.hyperConstraintsEnabled();
+  solver.sudoku().reset(_puzzle);
+  if (_numSolutions > 0) {
+    // The search then finds the known solution first
+    solver.setPreferredValues(_solutions[0]);
+  }
+  solver.setSolutionBuffer(_solutions[0], maxTrackedSolutions);
+  solver.setSearchLimits(maxCountNodes, 0);
+  solver.startCountSolutions();
+
+  return false;
+}
+
+SolutionCount SolutionTracker::puzzleChanged() {
+  _restart = true;
+
+  if (numConsistentSolutions() == maxTrackedSolutions) {
+    _solutionCount = SolutionCount::Multiple;
+  } else {
+    _solutionCount = SolutionCount::Computing;
+  }
+
+  return _solutionCount;
+}
+
+bool SolutionTracker::step(Solver& solver, uint32_t budgetMicros) {
+  if (_restart || !solver.isSearching()) {
+    solver.cancel();
+    _restart = false;
+    if (startSearch(solver)) {
+      return true;
+    }
+  }
+
+  if (!solver.step(budgetMicros)) {
+    return false;
+  }
+
+  _numSolutions = solver.numSolutionsFound();
+  _solutionCount = (
+    solver.isExhausted() ? SolutionCount::Unknown : (SolutionCount)_numSolutions
+  );
+
+  return true;
+}
@@ -0,0 +1,78 @@
+/*
+ * Sudoku, a Gamebuino game
+ *
+ * Copyright 2018, Erwin Bonsma
+ */
+
+#ifndef __SOLUTION_TRACKER_INCLUDED
+#define __SOLUTION_TRACKER_INCLUDED
+
+#include "Solver.h"
+#include "Sudoku.h"
+
+const int maxTrackedSolutions = 2;
+
+// The number of solver nodes after which counting is given up, so that it
+// always ends. The count is then Unknown.
+const int maxCountNodes = 20000;
+
+/* Keeps track of the number of solutions of a puzzle that is being edited.
+ *
+ * It remembers the solutions that it found for earlier versions of the
+ * puzzle. A solution remains a solution when the edit is consistent with it,
+ * so when two are, the puzzle is known to have multiple solutions without
+ * searching. When one is, only the search for a second solution remains,
+ * which tries the values of the known solution first so that it quickly gets
+ * past it.
+ *
+ * Searches are done in steps of bounded duration, so that they can be spread
+ * over multiple frames. They use a solver on a puzzle of its own, which holds
+ * a copy of the edited puzzle. The solver is passed to each step, so that it
+ * can be used for other searches in between. When it was, the search is
+ * started again.
+ */
+class SolutionTracker {
+  // The puzzle that is being edited
+  Sudoku& _puzzle;
+
+  // Solutions found for (earlier versions of) the puzzle, as a bit value per
+  // cell
+  int _solutions[maxTrackedSolutions][numCells];
+  int _numSolutions;
+  // The puzzle type of the solutions
+  bool _hyper;
+
+  // Set when the puzzle changed after the search was started
+  bool _restart;
+
+  SolutionCount _solutionCount;
+
+  bool isConsistent(int solutionIndex);
+
+  /* Moves the solutions that are consistent with the puzzle to the front.
+   * Returns how many there are.
+   */
+  int numConsistentSolutions();
+
+  // Starts the search. Returns true when the count is already known.
+  bool startSearch(Solver& solver);
+
+public:
+  SolutionTracker(Sudoku& puzzle);
+
+  /* Should be invoked after the puzzle has been edited. Returns the solution
+   * count when it is known right away. Otherwise it returns Computing, and
+   * step() should be invoked until it is done.
+   */
+  SolutionCount puzzleChanged();
+
+  /* Continues counting the solutions until it is done or the given time has
+   * been spent. Returns true when it is done. A budget of zero means that
+   * there is no limit.
+   */
+  bool step(Solver& solver, uint32_t budgetMicros);
+
+  SolutionCount solutionCount() { return _solutionCount; }
+};
+
+#endif
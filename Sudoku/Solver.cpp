@@ -10,39 +10,106 @@
 #include "Solver.h"
 #include "Globals.h"
 
-Solver::Solver(Sudoku& s) : _s(s) {
+Solver::Solver(Sudoku& s)
+  : _s(s), _numPending(0), _pendingHead(0), _numDirty(0), _dirtyHead(0),
+    _branchOrder(BranchOrder::CellIndex), _propagationStages(0),
+    _numEliminations(0), _snapshots(NULL), _maxSnapshots(0), _depth(0),
+    _searchPhase(SearchPhase::Idle), _excludedCell(-1), _solutions(NULL),
+    _maxSolutions(0), _maxNodes(0), _maxMicros(0), _cancelFlag(NULL),
+    _exhausted(false), _numNodes(0), _numBacktracks(0) {
   for (int i = 0; i < numCells; i++) {
     _offsets[i] = 0;
   }
+  for (int i = 0; i < numConstraintGroups; i++) {
+    _dirtyValues[i] = 0;
+  }
+  for (int i = 0; i < numCells; i++) {
+    _eliminated[i] = 0;
+  }
+  SOLVER_STAT(_stats.reset());
+}
+
+void Solver::markSet(int cellIndex) {
+  int pos = _unsetPos[cellIndex];
+  int last = _unsetCells[--_numUnset];
+
+  // Swap with the last unset cell
+  _unsetCells[pos] = last;
+  _unsetPos[last] = pos;
+  _unsetCells[_numUnset] = cellIndex;
+  _unsetPos[cellIndex] = _numUnset;
+}
+
+void Solver::markUnset(int cellIndex) {
+  assertTrue(_unsetCells[_numUnset] == cellIndex);
+  _numUnset++;
 }
 
-bool Solver::postAutoSet(SudokuCell& cell) {
+template <class Layout>
+int Solver::minRemainingCell() {
+  int bestIndex = numCells;
+  int bestCount = numValues + 1;
+
+  for (int i = _numUnset; --i >= 0; ) {
+    int cellIndex = _unsetCells[i];
+    int count = countBits(possibleMask<Layout>(cellIndex));
+    if (count < bestCount) {
+      bestIndex = cellIndex;
+      bestCount = count;
+      if (count <= 2) {
+        // Cells with only one value are set automatically, so cannot do better
+        break;
+      }
+    }
+  }
+
+  return bestIndex;
+}
+
+void Solver::postAutoSet(SudokuCell& cell) {
   // Record the cell that has been auto-set, to enable undo when backtracking
   _autoSetCells[_totalAutoSet++] = cell.index();
+  markSet(cell.index());
+  SOLVER_STAT(
+    if (_totalAutoSet > _stats.maxAutoSet) { _stats.maxAutoSet = _totalAutoSet; }
+  )
 
-  // Recurse to maybe set more
-  return postSet(cell);
+  _pendingCells[_numPending++] = cell.index();
 }
 
 void Solver::autoClear(int num) {
   while (num-- > 0) {
-    _s.clearValue(_s.cellAt(_autoSetCells[--_totalAutoSet]));
+    int cellIndex = _autoSetCells[--_totalAutoSet];
+    _s.clearValue(_s.cellAt(cellIndex));
+    markUnset(cellIndex);
   }
 }
 
+template <class Layout>
 bool Solver::checkSingleValue(int cellIndex) {
   SudokuCell& cell = _s.cellAt(cellIndex);
-  AutoSetResult result = _s.autoSet(cell);
+  if (cell.isSet()) {
+    return false;
+  }
+
+  // Equivalent to Sudoku::autoSet(), but with the mask for the layout
+  int m = possibleMask<Layout>(cellIndex);
+  if (m == 0) {
+    return true; // Stuck
+  }
 
-  if (result == AutoSetResult::CellUpdated) {
-    return postAutoSet(cell);
+  // Next evaluates to zero if only one bit was set
+  if ((m & (m - 1)) == 0) {
+    _s.setBitValue(cell, m);
+    postAutoSet(cell);
+    SOLVER_STAT(_stats.numNakedSingles++);
   }
 
-  // Signal when stuck
-  return (result == AutoSetResult::Stuck);
+  return false;
 }
 
-bool Solver::checkSinglePosition(int mask, int* cellIndices) {
+template <class Layout>
+bool Solver::checkSinglePosition(int mask, const int* cellIndices) {
   for (int bit = maxBitValue; bit > 0; bit >>= 1) {
     if ((mask & bit) != 0) {
       // Value not yet set in given group. Check possible positions
@@ -53,7 +120,7 @@ bool Solver::checkSinglePosition(int mask, int* cellIndices) {
       while (--i >= 0 && cnt < 2) {
         int ci = cellIndices[i];
         SudokuCell& cell = _s.cellAt(ci);
-        if (!cell.isSet() && cell.isBitPossible(bit)) {
+        if (!cell.isSet() && (possibleMask<Layout>(ci) & bit) != 0) {
           posIndex = ci;
           cnt++;
         }
@@ -64,7 +131,9 @@ bool Solver::checkSinglePosition(int mask, int* cellIndices) {
       if (cnt == 1) {
         SudokuCell& cell = _s.cellAt(posIndex);
         _s.setBitValue(cell, bit);
-        return postAutoSet(cell);
+        postAutoSet(cell);
+        SOLVER_STAT(_stats.numHiddenSingles++);
+        return false;
       }
     }
   }
@@ -72,26 +141,315 @@ bool Solver::checkSinglePosition(int mask, int* cellIndices) {
   return false;
 }
 
-bool Solver::postSet(SudokuCell& cell) {
-  for (int i = maxConstraintsPerCell; --i >= 0; ) {
+void Solver::markDirty(int groupIndex, int mask) {
+  if (_dirtyValues[groupIndex] == 0) {
+    _dirtyGroups[(_dirtyHead + _numDirty++) % numConstraintGroups] = groupIndex;
+  }
+  _dirtyValues[groupIndex] |= mask;
+}
+
+void Solver::clearQueues() {
+  while (_numDirty > 0) {
+    _dirtyValues[_dirtyGroups[_dirtyHead]] = 0;
+    _dirtyHead = (_dirtyHead + 1) % numConstraintGroups;
+    _numDirty--;
+  }
+  _numPending = 0;
+  _pendingHead = 0;
+}
+
+template <class Layout>
+void Solver::queueSetCell(int cellIndex) {
+  SudokuCell& cell = _s.cellAt(cellIndex);
+  int bit = cell.getBitValue();
+
+  for (int i = Layout::numCellConstraints; --i >= 0; ) {
     int groupIndex = cell._constraintGroup[i];
-    int* cellIndices = constraintCells[groupIndex];
+    markDirty(groupIndex, maxBitMask);
+
+    const int* cellIndices = constraintCells[groupIndex];
     for (int j = constraintGroupSize; --j >= 0; ) {
-      if (checkSingleValue(cellIndices[j])) {
-        return true; // Stuck
+      SudokuCell& peer = _s.cellAt(cellIndices[j]);
+      if (!peer.isSet()) {
+        for (int k = Layout::numCellConstraints; --k >= 0; ) {
+          markDirty(peer._constraintGroup[k], bit);
+        }
+      }
+    }
+  }
+}
+
+template <class Layout>
+int Solver::possiblePositions(int groupIndex, int bit) {
+  const int* cellIndices = constraintCells[groupIndex];
+  int positions = 0;
+
+  for (int j = constraintGroupSize; --j >= 0; ) {
+    int ci = cellIndices[j];
+    if (!_s.cellAt(ci).isSet() && (possibleMask<Layout>(ci) & bit) != 0) {
+      positions |= 1 << j;
+    }
+  }
+
+  return positions;
+}
+
+template <class Layout>
+bool Solver::eliminate(int cellIndex, int mask) {
+  SudokuCell& cell = _s.cellAt(cellIndex);
+  if (cell.isSet()) {
+    return false;
+  }
+
+  mask &= possibleMask<Layout>(cellIndex);
+  if (mask == 0 || _numEliminations == maxEliminations) {
+    return false;
+  }
+
+  _eliminationCells[_numEliminations] = cellIndex;
+  _eliminationMasks[_numEliminations++] = mask;
+  _eliminated[cellIndex] |= mask;
+
+  for (int i = Layout::numCellConstraints; --i >= 0; ) {
+    markDirty(cell._constraintGroup[i], mask);
+  }
+
+  return checkSingleValue<Layout>(cellIndex);
+}
+
+void Solver::undoEliminations(int num) {
+  while (_numEliminations > num) {
+    _numEliminations--;
+    _eliminated[_eliminationCells[_numEliminations]] &= ~_eliminationMasks[_numEliminations];
+  }
+}
+
+template <class Layout>
+bool Solver::checkLockedCandidates(int groupIndex) {
+  const int* cellIndices = constraintCells[groupIndex];
+  int mask = _s._state.constraintMask[groupIndex];
+
+  for (int bit = maxBitValue; bit > 0; bit >>= 1) {
+    if ((mask & bit) == 0) {
+      continue;
+    }
+
+    int positions = possiblePositions<Layout>(groupIndex, bit);
+    if ((positions & (positions - 1)) == 0) {
+      // Zero or one position. This is handled by checkSinglePosition
+      continue;
+    }
+
+    // Check if all positions share another group
+    SudokuCell& first = _s.cellAt(cellIndices[bitToValue(positions) - 1]);
+    for (int k = Layout::numCellConstraints; --k >= 0; ) {
+      int otherIndex = first._constraintGroup[k];
+      if (otherIndex == groupIndex) {
+        continue;
+      }
+
+      bool shared = true;
+      for (int j = constraintGroupSize; --j >= 0 && shared; ) {
+        if ((positions & (1 << j)) != 0) {
+          shared = (_s.cellAt(cellIndices[j])._constraintGroup[k] == otherIndex);
+        }
+      }
+      if (!shared) {
+        continue;
+      }
+
+      // The value must go in the intersection, so eliminate it from the rest
+      // of the other group
+      const int* otherIndices = constraintCells[otherIndex];
+      for (int j = constraintGroupSize; --j >= 0; ) {
+        SudokuCell& cell = _s.cellAt(otherIndices[j]);
+        bool inGroup = false;
+        for (int l = Layout::numCellConstraints; --l >= 0; ) {
+          inGroup |= (cell._constraintGroup[l] == groupIndex);
+        }
+        if (!inGroup && eliminate<Layout>(otherIndices[j], bit)) {
+          return true; // Stuck
+        }
+      }
+    }
+  }
+
+  return false;
+}
+
+template <class Layout>
+bool Solver::checkNakedSubsets(int groupIndex) {
+  const int* cellIndices = constraintCells[groupIndex];
+
+  // Candidate members: unset cells with at most three possible values
+  int members[constraintGroupSize];
+  int masks[constraintGroupSize];
+  int n = 0;
+  for (int j = 0; j < constraintGroupSize; j++) {
+    int ci = cellIndices[j];
+    if (!_s.cellAt(ci).isSet()) {
+      int m = possibleMask<Layout>(ci);
+      if (countBits(m) <= 3) {
+        members[n] = j;
+        masks[n++] = m;
+      }
+    }
+  }
+
+  for (int a = 0; a < n; a++) {
+    for (int b = a + 1; b < n; b++) {
+      for (int c = b; c < n; c++) {
+        // When c == b, the subset is the pair a, b
+        int size = (c == b) ? 2 : 3;
+        int values = masks[a] | masks[b] | masks[c];
+        int numValues = countBits(values);
+        if (numValues < size) {
+          return true; // Stuck: too few values for these cells
+        }
+        if (numValues > size) {
+          continue;
+        }
+
+        for (int j = constraintGroupSize; --j >= 0; ) {
+          if (j != members[a] && j != members[b] && j != members[c]) {
+            if (eliminate<Layout>(cellIndices[j], values)) {
+              return true; // Stuck
+            }
+          }
+        }
       }
     }
   }
 
-  for (int i = _numActiveConstraints; --i >= 0; ) {
-    if (checkSinglePosition(_s._constraintMask[i], constraintCells[i])) {
+  return false;
+}
+
+template <class Layout>
+bool Solver::checkHiddenSubsets(int groupIndex) {
+  const int* cellIndices = constraintCells[groupIndex];
+  int mask = _s._state.constraintMask[groupIndex];
+
+  // Candidate members: values with at most three possible positions
+  int members[numValues];
+  int positions[numValues];
+  int n = 0;
+  for (int bit = 1; bit <= maxBitValue; bit <<= 1) {
+    if ((mask & bit) != 0) {
+      int p = possiblePositions<Layout>(groupIndex, bit);
+      if (countBits(p) <= 3) {
+        members[n] = bit;
+        positions[n++] = p;
+      }
+    }
+  }
+
+  for (int a = 0; a < n; a++) {
+    for (int b = a + 1; b < n; b++) {
+      for (int c = b; c < n; c++) {
+        // When c == b, the subset is the pair a, b
+        int size = (c == b) ? 2 : 3;
+        int cells = positions[a] | positions[b] | positions[c];
+        int numPositions = countBits(cells);
+        if (numPositions < size) {
+          return true; // Stuck: too few positions for these values
+        }
+        if (numPositions > size) {
+          continue;
+        }
+
+        int others = maxBitMask & ~(members[a] | members[b] | members[c]);
+        for (int j = constraintGroupSize; --j >= 0; ) {
+          if ((cells & (1 << j)) != 0 && eliminate<Layout>(cellIndices[j], others)) {
+            return true; // Stuck
+          }
+        }
+      }
+    }
+  }
+
+  return false;
+}
+
+template <class Layout>
+bool Solver::applyPropagationStages() {
+  for (int i = Layout::numActiveConstraints; --i >= 0; ) {
+    if (
+      ((_propagationStages & lockedCandidatesStage) != 0 && checkLockedCandidates<Layout>(i)) ||
+      ((_propagationStages & nakedSubsetsStage) != 0 && checkNakedSubsets<Layout>(i)) ||
+      ((_propagationStages & hiddenSubsetsStage) != 0 && checkHiddenSubsets<Layout>(i))
+    ) {
+      return true; // Stuck
+    }
+  }
+
+  return false;
+}
+
+template <class Layout>
+bool Solver::propagate() {
+  while (true) {
+    // First handle all cells that were set. Their peers may now have only one
+    // possible value left.
+    while (_pendingHead < _numPending) {
+      int cellIndex = _pendingCells[_pendingHead++];
+      SudokuCell& cell = _s.cellAt(cellIndex);
+
+      for (int i = Layout::numCellConstraints; --i >= 0; ) {
+        const int* cellIndices = constraintCells[cell._constraintGroup[i]];
+        for (int j = constraintGroupSize; --j >= 0; ) {
+          if (checkSingleValue<Layout>(cellIndices[j])) {
+            clearQueues();
+            return true; // Stuck
+          }
+        }
+      }
+
+      queueSetCell<Layout>(cellIndex);
+    }
+
+    if (_numDirty == 0) {
+      if (_propagationStages == 0) {
+        break;
+      }
+
+      // The singles are exhausted. Try the optional stages, and continue as
+      // long as these eliminate values.
+      int numEliminationsBefore = _numEliminations;
+      if (applyPropagationStages<Layout>()) {
+        clearQueues();
+        return true; // Stuck
+      }
+      if (_numPending == _pendingHead && _numDirty == 0) {
+        assertTrue(_numEliminations == numEliminationsBefore);
+        break;
+      }
+      continue;
+    }
+
+    // Check the next dirty group for values with only one possible position
+    int groupIndex = _dirtyGroups[_dirtyHead];
+    _dirtyHead = (_dirtyHead + 1) % numConstraintGroups;
+    _numDirty--;
+    int mask = _s._state.constraintMask[groupIndex] & _dirtyValues[groupIndex];
+    _dirtyValues[groupIndex] = 0;
+
+    if (checkSinglePosition<Layout>(mask, constraintCells[groupIndex])) {
+      clearQueues();
       return true; // Stuck
     }
   }
 
+  _numPending = 0;
+  _pendingHead = 0;
   return false;
 }
 
+template <class Layout>
+bool Solver::postSet(SudokuCell& cell) {
+  _pendingCells[_numPending++] = cell.index();
+  return propagate<Layout>();
+}
+
 bool Solver::setImplicitMasks() {
   if (!_s.hyperConstraintsEnabled()) {
     return false;
@@ -99,7 +457,7 @@ bool Solver::setImplicitMasks() {
 
   for (int i = numExplicitConstraintGroups; i < numConstraintGroups; i++) {
     int m = maxBitMask;
-    int* cellIndices = constraintCells[i];
+    const int* cellIndices = constraintCells[i];
     for (int j = constraintGroupSize; --j >= 0; ) {
       int val = _s.cellAt(cellIndices[j]).getBitValue();
       if (val > 0) {
@@ -112,98 +470,300 @@ bool Solver::setImplicitMasks() {
         }
       }
     }
-    _s._constraintMask[i] = m;
+    _s._state.constraintMask[i] = m;
   }
 
   return false;
 }
 
+template <class Layout>
 bool Solver::initialAutoSet() {
+  // Check if each value in a constraint group still has possible positions
+  for (int i = Layout::numActiveConstraints; --i >= 0; ) {
+    markDirty(i, maxBitMask);
+  }
+
   // Check if each cell still has possible values
   for (int i = numCells; --i >= 0; ) {
-    if (checkSingleValue(i)) {
+    if (checkSingleValue<Layout>(i)) {
+      clearQueues();
       return true; // Stuck
     }
   }
 
-  // Checks if each value in a constraint group still has allowed positions
-  for (int i = _numActiveConstraints; --i >= 0; ) {
-    if (checkSinglePosition(_s._constraintMask[i], constraintCells[i])) {
-      return true; // Stuck
+  return propagate<Layout>();
+}
+
+void Solver::undoValue() {
+  SearchFrame& frame = _frames[_depth - 1];
+  SOLVER_STAT(_stats.numAutoCleared += _totalAutoSet - frame.totalAutoSetBefore);
+
+  if (_depth <= _maxSnapshots) {
+    _s.restoreState(_snapshots[_depth - 1]);
+    // The cells set since the snapshot are still recorded at the end of these
+    // stacks, and can simply be dropped.
+    _totalAutoSet = frame.totalAutoSetBefore;
+    _numUnset = frame.numUnsetBefore;
+  } else {
+    autoClear(_totalAutoSet - frame.totalAutoSetBefore);
+    _s.clearValue(_s.cellAt(frame.cellIndex));
+    markUnset(frame.cellIndex);
+  }
+  undoEliminations(frame.numEliminationsBefore);
+}
+
+void Solver::unwind() {
+  if (_searchPhase == SearchPhase::Next) {
+    // The value of the top frame is not set
+    _depth--;
+  }
+  while (_depth > 0) {
+    undoValue();
+    _depth--;
+  }
+}
+
+bool Solver::isLimitReached() {
+  return (
+    (_maxNodes != 0 && _numNodes >= _maxNodes) ||
+    (_maxMicros != 0 && timeMicros() - _searchStartTime >= _maxMicros) ||
+    (_cancelFlag != NULL && _cancelFlag->load(std::memory_order_relaxed))
+  );
+}
+
+void Solver::returnFromDepth(bool found) {
+  while (_depth > 0) {
+    if (!found) {
+      undoValue();
+      _numBacktracks++;
+      SOLVER_STAT(_stats.numBacktracks++);
+      _searchPhase = SearchPhase::Next;
+      return;
+    }
+
+    // Terminate. The values of the solution are kept unless the puzzle should
+    // be restored.
+    if (_restore) {
+      undoValue();
     }
+    _depth--;
   }
 
-  return false;
+  _searchPhase = SearchPhase::Done;
 }
 
-bool Solver::solve(int n) {
-  if (n == numCells) {
-    _numSolutionsFound++;
-    return (_numSolutionsFound == _numSolutionsToFind);
+template <class Layout>
+bool Solver::runSearch(uint32_t budgetMicros, int budgetNodes) {
+  uint32_t startTime = (budgetMicros != 0) ? timeMicros() : 0;
+  int nodeLimit = _numNodes + budgetNodes;
+
+  if (_searchPhase == SearchPhase::Start) {
+    if (initialAutoSet<Layout>()) {
+      _searchPhase = SearchPhase::Done;
+      return true;
+    }
+    _nextCell = 0;
+    _searchPhase = SearchPhase::Enter;
   }
 
-  SudokuCell& cell = _s.cellAt(n);
-  if (cell.isSet()) {
-    // Cell already auto-filled
-    return solve(n + 1);
-  }
-
-  int i = numValues;
-  bool terminate = false;
-  int totalAutoSetBefore = _totalAutoSet;
-  int bit = 1 << _offsets[n];
-  while (--i >= 0 && !terminate) {
-    if (cell.isBitPossible(bit)) {
-      _s.setBitValue(cell, bit);
-
-      bool stuck = postSet(cell);
-      if (!stuck) {
-        if (solve(n + 1)) {
-          if (_restore) {
-            terminate = true;
-          }
-          else {
-            return true;
+  while (_searchPhase != SearchPhase::Done) {
+    if (budgetMicros != 0 && timeMicros() - startTime >= budgetMicros) {
+      return false;
+    }
+    if (budgetNodes != 0 && _numNodes >= nodeLimit) {
+      return false;
+    }
+    if (isLimitReached()) {
+      _exhausted = true;
+      unwind();
+      _searchPhase = SearchPhase::Done;
+      break;
+    }
+
+    if (_searchPhase == SearchPhase::Enter) {
+      int n = _nextCell;
+      if (_branchOrder == BranchOrder::MinRemaining) {
+        n = minRemainingCell<Layout>();
+      } else {
+        // Skip cells that are already (auto-)filled
+        while (n < numCells && _s.cellAt(n).isSet()) {
+          n++;
+        }
+      }
+
+      if (n == numCells) {
+        if (_numSolutionsFound < _maxSolutions) {
+          int* solution = _solutions + _numSolutionsFound * numCells;
+          for (int i = 0; i < numCells; i++) {
+            solution[i] = _s.cellAt(i).getBitValue();
           }
         }
+        _numSolutionsFound++;
+        returnFromDepth(_numSolutionsFound == _numSolutionsToFind);
+        continue;
       }
 
-      autoClear(_totalAutoSet - totalAutoSetBefore);
-      _s.clearValue(cell);
+      SearchFrame& frame = _frames[_depth];
+      frame.cellIndex = n;
+      frame.numUntried = numValues;
+      frame.bit = 1 << _offsets[n];
+      frame.possible = possibleMask<Layout>(n);
+      frame.totalAutoSetBefore = _totalAutoSet;
+      frame.numEliminationsBefore = _numEliminations;
+      frame.numUnsetBefore = _numUnset;
+
+      if (_depth < _maxSnapshots) {
+        _s.saveState(_snapshots[_depth]);
+      }
+      _depth++;
+      SOLVER_STAT(
+        if (_depth > _stats.maxDepth) { _stats.maxDepth = _depth; }
+      )
+      _searchPhase = SearchPhase::Next;
+    }
+
+    // Try the next possible value for the cell at the current depth
+    SearchFrame& frame = _frames[_depth - 1];
+    int bit = 0;
+    while (bit == 0 && frame.numUntried > 0) {
+      if ((frame.possible & frame.bit) != 0) {
+        bit = frame.bit;
+      }
+      frame.numUntried--;
+      frame.bit >>= 1;
+      if (frame.bit == 0) {
+        frame.bit = maxBitValue;
+      }
     }
 
-    bit >>= 1;
     if (bit == 0) {
-      bit = maxBitValue;
+      // All values have been tried
+      _depth--;
+      returnFromDepth(false);
+      continue;
+    }
+
+    SudokuCell& cell = _s.cellAt(frame.cellIndex);
+    _s.setBitValue(cell, bit);
+    markSet(frame.cellIndex);
+    _numNodes++;
+    SOLVER_STAT(_stats.numNodes++);
+
+    if (postSet<Layout>(cell)) {
+      // Stuck
+      undoValue();
+      _numBacktracks++;
+      SOLVER_STAT(_stats.numBacktracks++);
+    } else {
+      _nextCell = frame.cellIndex + 1;
+      _searchPhase = SearchPhase::Enter;
     }
   }
 
-  return terminate;
+  return true;
 }
 
-int Solver::findSolutions(bool restore, int numSolutionsToFind) {
+void Solver::startSearch(bool restore, int numSolutionsToFind) {
+  assertTrue(_searchPhase == SearchPhase::Idle);
+
   _restore = restore;
   _numSolutionsToFind = numSolutionsToFind;
 
   _numSolutionsFound = 0;
+  _exhausted = false;
+  _searchStartTime = (_maxMicros != 0) ? timeMicros() : 0;
   _totalAutoSet = 0;
-  _numActiveConstraints = (
-    _s.hyperConstraintsEnabled()
-    ? numConstraintGroups
-    : numBasicConstraintGroups
-  );
+  _numNodes = 0;
+  _numBacktracks = 0;
+  _depth = 0;
 
-  if (!setImplicitMasks()) {
-    if (!initialAutoSet()) {
-      solve(0);
+  // Auto-fix is disabled during the search, so that the solver never changes
+  // which cells are fixed. This is required for restoring snapshots.
+  _autoFixBefore = _s.isAutoFixEnabled();
+  _s.setAutoFix(false);
+
+  _numUnset = 0;
+  for (int i = 0; i < numCells; i++) {
+    if (!_s.cellAt(i).isSet()) {
+      _unsetPos[i] = _numUnset;
+      _unsetCells[_numUnset++] = i;
     }
+  }
+
+  _searchPhase = setImplicitMasks() ? SearchPhase::Done : SearchPhase::Start;
+}
+
+void Solver::finishSearch() {
+  if (_restore) {
+    // Clear cells set by autoSet()
+    autoClear(_totalAutoSet);
+  }
 
-    if (restore) {
-      // Clear cells set by autoSet()
-      autoClear(_totalAutoSet);
+  // Eliminations are only meaningful during the search
+  undoEliminations(0);
+  if (_excludedCell >= 0) {
+    _eliminated[_excludedCell] = 0;
+    _excludedCell = -1;
+  }
+
+  _s.setAutoFix(_autoFixBefore);
+  _solutions = NULL;
+  _maxSolutions = 0;
+  _maxNodes = 0;
+  _maxMicros = 0;
+  _searchPhase = SearchPhase::Idle;
+}
+
+void Solver::cancel() {
+  if (_searchPhase == SearchPhase::Idle) {
+    return;
+  }
+
+  if (_restore) {
+    unwind();
+  }
+  finishSearch();
+}
+
+void Solver::setSolutionBuffer(int* buffer, int maxSolutions) {
+  assertTrue(_searchPhase == SearchPhase::Idle);
+
+  _solutions = buffer;
+  _maxSolutions = (buffer != NULL) ? maxSolutions : 0;
+}
+
+bool Solver::continueSearch(uint32_t budgetMicros, int budgetNodes) {
+  if (_searchPhase == SearchPhase::Idle) {
+    return true;
+  }
+
+  if (_searchPhase != SearchPhase::Done) {
+    bool done = (
+      _s.hyperConstraintsEnabled()
+      ? runSearch<HyperLayout>(budgetMicros, budgetNodes)
+      : runSearch<NormalLayout>(budgetMicros, budgetNodes)
+    );
+    if (!done) {
+      return false;
     }
   }
 
+  finishSearch();
+  return true;
+}
+
+bool Solver::step(uint32_t budgetMicros) {
+  return continueSearch(budgetMicros, 0);
+}
+
+bool Solver::stepNodes(int numNodes) {
+  return continueSearch(0, numNodes);
+}
+
+int Solver::findSolutions(bool restore, int numSolutionsToFind) {
+  startSearch(restore, numSolutionsToFind);
+  step(0);
+
   return _numSolutionsFound;
 }
 
@@ -212,17 +772,74 @@ bool Solver::solve() {
 }
 
 bool Solver::randomSolve() {
-  for (int i = numCells; --i >= 0; ) {
-    _offsets[i] = rand() % numValues;
-  }
-  return solve();
+  startRandomSolve();
+  step(0);
+
+  return (_numSolutionsFound == 1);
 }
 
 bool Solver::isSolvable() {
   return (findSolutions(true, 1) == 1);
 }
 
+bool Solver::isSolvableWithout(SudokuCell& cell, int bit) {
+  startIsSolvableWithout(cell, bit);
+  step(0);
+
+  return (_numSolutionsFound == 1);
+}
+
+void Solver::startSolve() {
+  startSearch(false, 1);
+}
+
+void Solver::startRandomSolve() {
+  for (int i = numCells; --i >= 0; ) {
+    _offsets[i] = _random.next(numValues);
+  }
+  startSearch(false, 1);
+}
+
+void Solver::startIsSolvable() {
+  startSearch(true, 1);
+}
+
+void Solver::startIsSolvableWithout(SudokuCell& cell, int bit) {
+  assertTrue(!cell.isSet());
+
+  // Eliminations are all undone after a search, so this is not affected. It is
+  // reset when the search finishes.
+  _excludedCell = cell.index();
+  _eliminated[_excludedCell] = bit;
+  startSearch(true, 1);
+}
+
+void Solver::startCountSolutions() {
+  startSearch(true, 2);
+}
+
+void Solver::setSnapshotBuffer(SudokuState* buffer, int size) {
+  _snapshots = buffer;
+  _maxSnapshots = (buffer != NULL) ? size : 0;
+}
+
+void Solver::setPreferredValues(const int* bits) {
+  for (int i = numCells; --i >= 0; ) {
+    // solve() tries the value at the offset first
+    _offsets[i] = (bits[i] != 0) ? bitToValue(bits[i]) - 1 : 0;
+  }
+}
+
 SolutionCount Solver::countSolutions() {
-  return (SolutionCount)findSolutions(true, 2);
+  int numSolutions = findSolutions(true, 2);
+
+  return _exhausted ? SolutionCount::Unknown : (SolutionCount)numSolutions;
+}
+
+void Solver::setSearchLimits(int maxNodes, uint32_t maxMicros) {
+  assertTrue(_searchPhase == SearchPhase::Idle);
+
+  _maxNodes = maxNodes;
+  _maxMicros = maxMicros;
 }
 
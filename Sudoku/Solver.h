@@ -7,6 +7,8 @@
 #ifndef __SOLVER_INCLUDED
 #define __SOLVER_INCLUDED
 
+#include <atomic>
+
 #include "Sudoku.h"
 
 //------------------------------------------------------------------------------
@@ -14,11 +16,146 @@
 enum class SolutionCount : int {
   None = 0,
   One = 1,
-  Multiple = 2
+  Multiple = 2,
+  // Not yet known, as the solutions are still being counted
+  Computing = 3,
+  // Not known, as counting was stopped before it was done
+  Unknown = 4
+};
+
+//------------------------------------------------------------------------------
+
+/* Optional propagation stages, in addition to naked and hidden singles. These
+ * eliminate values from cells, which can reduce the size of the search tree,
+ * at the cost of more work per node.
+ */
+// Values in a group that are confined to its intersection with another group
+// are eliminated from the rest of that group (pointing and claiming)
+const int lockedCandidatesStage = 0x01;
+// N cells in a group with only N values between them (for N = 2 and 3)
+const int nakedSubsetsStage = 0x02;
+// N values in a group that only fit in N cells (for N = 2 and 3)
+const int hiddenSubsetsStage = 0x04;
+const int allPropagationStages = 0x07;
+
+// Maximum number of eliminations that can be undone. When it is exceeded,
+// further eliminations are skipped, which is safe as they are only an
+// optimization.
+const int maxEliminations = 2 * numCells;
+
+//------------------------------------------------------------------------------
+
+// The order in which the solver selects the cells to branch on
+enum class BranchOrder : int {
+  // Cells are visited in index order (row by row)
+  CellIndex,
+  // The unset cell with the fewest possible values is selected
+  MinRemaining
+};
+
+//------------------------------------------------------------------------------
+
+// The progress of a search, so that it can be suspended and resumed
+enum class SearchPhase : int {
+  // No search is in progress
+  Idle,
+  // The initial propagation still needs to be done
+  Start,
+  // A new depth should be entered, by branching on the next cell
+  Enter,
+  // The next value should be tried for the cell at the current depth
+  Next,
+  // The search is done, but the puzzle still needs to be restored
+  Done
+};
+
+/* The state of the search at one depth. It replaces the local variables of a
+ * recursive search, so that the search can be suspended at any point.
+ */
+struct SearchFrame {
+  // The cell that the search branches on
+  int16_t cellIndex;
+  // The number of values that remain to be checked
+  int16_t numUntried;
+  // The next value to try, and the values that were possible at the start
+  CompactMask bit;
+  CompactMask possible;
+
+  // The solver's bookkeeping before setting the cell, for backtracking
+  int16_t totalAutoSetBefore;
+  int16_t numEliminationsBefore;
+  int16_t numUnsetBefore;
+};
+
+//------------------------------------------------------------------------------
+
+#ifdef SOLVER_STATS
+
+/* Statistics of all searches of a solver since it was created, or since they
+ * were last reset. These are only collected when SOLVER_STATS is defined, as
+ * they cost time in the inner loop of the search.
+ */
+struct SolverStats {
+  // The values tried when branching
+  long numNodes;
+  // Cells set by propagation, because they have only one possible value
+  // (naked singles), or because a value has only one possible position in a
+  // group (hidden singles)
+  long numNakedSingles;
+  long numHiddenSingles;
+  // Values tried when branching that did not lead to a (wanted) solution
+  long numBacktracks;
+  // Cells set by propagation that were undone again when backtracking, or
+  // when restoring the puzzle
+  long numAutoCleared;
+  // The deepest branch, and the most cells set by propagation at once
+  int maxDepth;
+  int maxAutoSet;
+
+  void reset() {
+    numNodes = 0;
+    numNakedSingles = 0;
+    numHiddenSingles = 0;
+    numBacktracks = 0;
+    numAutoCleared = 0;
+    maxDepth = 0;
+    maxAutoSet = 0;
+  }
+};
+
+  #define SOLVER_STAT(statement) statement
+#else
+  #define SOLVER_STAT(statement)
+#endif
+
+//------------------------------------------------------------------------------
+
+/* Compile-time descriptions of the puzzle types. The solver's search is
+ * instantiated for each, so that the constraint checks per cell and the loops
+ * over the constraint groups are fixed at compile time, instead of being
+ * looked up for every cell that is visited.
+ */
+struct NormalLayout {
+  static const bool hyper = false;
+  // The constraint groups the solver checks
+  static const int numActiveConstraints = numBasicConstraintGroups;
+  // The constraint groups per cell that are active
+  static const int numCellConstraints = numBasicConstraintsPerCell;
+};
+
+struct HyperLayout {
+  static const bool hyper = true;
+  // Includes the implicit hyper-boxes
+  static const int numActiveConstraints = numConstraintGroups;
+  static const int numCellConstraints = maxConstraintsPerCell;
 };
 
 //------------------------------------------------------------------------------
 
+/* Solver for both puzzle types. The private methods that are templated on the
+ * layout (NormalLayout or HyperLayout) form the search. Each search is done
+ * entirely by one instantiation.
+ */
 class Solver {
 
   // The puzzle to solve
@@ -34,6 +171,10 @@ class Solver {
   // puzzles)
   int _offsets[numCells];
 
+  // Source of randomness for randomSolve(). It is also used by the Stripper
+  // that operates on the same puzzle.
+  Random _random;
+
   // Specifies if the solver should restore the puzzle to its original position
   // or not
   bool _restore;
@@ -43,37 +184,183 @@ class Solver {
 
   int _numSolutionsFound;
 
-  int _numActiveConstraints;
+  /* Queue of cells that have been set, but whose consequences have not yet
+   * been propagated. A cell is set at most once during a propagation, so it
+   * cannot overflow.
+   */
+  int _pendingCells[numCells];
+  int _numPending;
+  int _pendingHead;
+
+  /* For each constraint group, the values whose possible positions may have
+   * changed since the group was last checked for hidden singles. Groups with
+   * dirty values are queued in _dirtyGroups (a ring buffer).
+   */
+  int _dirtyValues[numConstraintGroups];
+  int _dirtyGroups[numConstraintGroups];
+  int _numDirty;
+  int _dirtyHead;
+
+  BranchOrder _branchOrder;
+
+  // The enabled optional propagation stages
+  int _propagationStages;
+
+  // For each cell, the values that have been eliminated by the optional
+  // propagation stages. These are on top of the constraint group masks.
+  int _eliminated[numCells];
+
+  // Trail of eliminations, to enable undo when backtracking
+  uint16_t _eliminationCells[maxEliminations];
+  CompactMask _eliminationMasks[maxEliminations];
+  int _numEliminations;
+
+  /* The cells that are not yet set. The first _numUnset entries are unset,
+   * followed by the cells that were set by the solver, in reverse order of
+   * setting. As cells are cleared in reverse order as well, restoring a cell
+   * only requires incrementing _numUnset.
+   */
+  int _unsetCells[numCells];
+  // Position of each unset cell in _unsetCells
+  int _unsetPos[numCells];
+  int _numUnset;
+
+  // Optional buffer for snapshots of the puzzle state, one per search depth
+  SudokuState* _snapshots;
+  int _maxSnapshots;
+
+  // Explicit stack of the search. Each depth sets at least one cell, so
+  // numCells entries suffice.
+  SearchFrame _frames[numCells];
+  // Current search depth, i.e. the number of frames on the stack
+  int _depth;
+
+  SearchPhase _searchPhase;
+  // The cell from which to look for the next cell to branch on
+  int _nextCell;
+
+  // Cell whose value was excluded by isSolvableWithout(), or -1 if none
+  int _excludedCell;
+
+  // The auto-fix setting of the puzzle before the search started
+  bool _autoFixBefore;
+
+  // Optional buffer for the solutions that the current search finds
+  int* _solutions;
+  int _maxSolutions;
+
+  // The limits of the current search, where zero means no limit
+  int _maxNodes;
+  uint32_t _maxMicros;
+  uint32_t _searchStartTime;
+
+  // Optional flag that stops the search when it gets set
+  const std::atomic<bool>* _cancelFlag;
+
+  // Set when the last search was stopped before it was done
+  bool _exhausted;
+
+  // Search statistics of the last solve. Nodes are the values tried when
+  // branching, backtracks the ones that did not lead to a (wanted) solution.
+  int _numNodes;
+  int _numBacktracks;
+
+#ifdef SOLVER_STATS
+  SolverStats _stats;
+#endif
 
   /* Invoked after a cell has been automatically set. It records the cell to
-   * enable backtracking. Furthermore, it checks if more cells can be
-   * automatically set.
-   *
-   * Returns true when stuck to signal that backtracking is required.
+   * enable backtracking, and queues it for propagation.
    */
-  bool postAutoSet(SudokuCell& cell);
+  void postAutoSet(SudokuCell& cell);
 
   /* Sets the given cell if it only has one possible value.
    *
    * Returns true when stuck to signal that backtracking is required.
    */
+  template <class Layout>
   bool checkSingleValue(int cellIndex);
 
-  /* Checks for all values that are not yet filled in within a given group (row,
-   * column or block) if there is only possible cell that can be assigned this
-   * value. If so it sets this cell and continues the recursion
+  /* Checks for the given values, which should not yet be filled in within the
+   * group (row, column or block), if there is only one possible cell that can
+   * be assigned this value. If so it sets this cell. As this changes the
+   * group, the group is then queued again and checking the remaining values is
+   * left to that.
    *
    * Returns true when stuck to signal that backtracking is required.
    */
-  bool checkSinglePosition(int mask, int* cellIndices);
+  template <class Layout>
+  bool checkSinglePosition(int mask, const int* cellIndices);
+
+  // Marks the given values as dirty for the group, queueing it if needed.
+  void markDirty(int groupIndex, int mask);
+
+  // The values that are possible for the given (unset) cell
+  template <class Layout>
+  int possibleMask(int cellIndex) {
+    return _s.cellAt(cellIndex).bitMask(Layout::hyper) & ~_eliminated[cellIndex];
+  }
+
+  // Returns for the given value the positions within the group where it is
+  // possible, as a mask with a bit per position.
+  template <class Layout>
+  int possiblePositions(int groupIndex, int bit);
+
+  /* Eliminates the given values from the cell. It may cause the cell to be
+   * automatically set.
+   *
+   * Returns true when stuck to signal that backtracking is required.
+   */
+  template <class Layout>
+  bool eliminate(int cellIndex, int mask);
+
+  // Undoes eliminations until only "num" remain.
+  void undoEliminations(int num);
+
+  // The optional propagation stages. Each returns true when stuck.
+  template <class Layout> bool checkLockedCandidates(int groupIndex);
+  template <class Layout> bool checkNakedSubsets(int groupIndex);
+  template <class Layout> bool checkHiddenSubsets(int groupIndex);
+  template <class Layout> bool applyPropagationStages();
+
+  // Empties the queues, e.g. after getting stuck.
+  void clearQueues();
+
+  /* Queues the consequences of setting the given cell. The cell's groups are
+   * marked dirty for all values, as the cell is no longer available. The
+   * groups of the cell's peers are marked dirty for the value that was set, as
+   * that is no longer possible for these peers.
+   */
+  template <class Layout>
+  void queueSetCell(int cellIndex);
+
+  /* Propagates the consequences of all queued changes. It iterates until no
+   * more cells can be automatically set. Each set cell only triggers checks
+   * of the groups and cells it actually affected.
+   *
+   * Returns true when stuck to signal that backtracking is required.
+   */
+  template <class Layout>
+  bool propagate();
 
   /* Invoked after a cell has been set. It checks if from this other cells can
    * be automatically set, and if so, does this.
    *
    * Returns true when stuck to signal that backtracking is required.
    */
+  template <class Layout>
   bool postSet(SudokuCell& cell);
 
+  // Bookkeeping for _unsetCells. Should be invoked after a cell was set or
+  // cleared by the solver.
+  void markSet(int cellIndex);
+  void markUnset(int cellIndex);
+
+  // Returns the unset cell with the fewest possible values, or numCells if all
+  // cells are set.
+  template <class Layout>
+  int minRemainingCell();
+
   /* Undos the last "num" cells that have been set automatically by
    * checkSingleValue and checkSinglePosition.
    */
@@ -97,10 +384,40 @@ class Solver {
    * up the solve time, especially when it becomes clear that the puzzle is not
    * solvable.
    */
+  template <class Layout>
   bool initialAutoSet();
 
-  // Returns "true" if the termination criterion has been reached.
-  bool solve(int n);
+  // Undoes the value that was set for the frame at the top of the stack.
+  void undoValue();
+
+  // Pops all frames, undoing their values.
+  void unwind();
+
+  // Returns true when the search should stop before it is done.
+  bool isLimitReached();
+
+  /* Pops the frames that should end given the outcome of the search below the
+   * top frame. When that did not find the (last wanted) solution, it only
+   * undoes the value of the top frame, so that the next value can be tried.
+   */
+  void returnFromDepth(bool found);
+
+  /* Continues the search until it is done or the time or node budget is
+   * used. Returns true when it is done. A budget of zero means that there is
+   * no limit.
+   */
+  template <class Layout>
+  bool runSearch(uint32_t budgetMicros, int budgetNodes);
+
+  // Invokes runSearch() for the layout of the puzzle, and finishes the search
+  // when it is done.
+  bool continueSearch(uint32_t budgetMicros, int budgetNodes);
+
+  // Sets up a search, which is then carried out by step().
+  void startSearch(bool restore, int numSolutionsToFind);
+
+  // Restores the puzzle and the solver after a search.
+  void finishSearch();
 
   /* Starts solving the possible. Returns the number of solutions found.
    *
@@ -117,10 +434,107 @@ public:
 
   Sudoku& sudoku() { return _s; }
 
+  Random& random() { return _random; }
+  void seedRandom(uint32_t seed) { _random.seed(seed); }
+
   bool solve();
   bool randomSolve();
   bool isSolvable();
+  // Returns Unknown when the search is exhausted (see setSearchLimits).
   SolutionCount countSolutions();
+
+  /* Checks if the puzzle can be solved without the given unset cell having
+   * the given value. When the puzzle has a known solution, this checks in a
+   * single search if there is another one.
+   */
+  bool isSolvableWithout(SudokuCell& cell, int bit);
+
+  /* Resumable variants of the searches above. Each sets up the search, which
+   * is then carried out by invoking step() until it returns true. Afterwards,
+   * numSolutionsFound() gives the result. The puzzle should not be changed
+   * while the search is in progress.
+   */
+  void startSolve();
+  void startRandomSolve();
+  void startIsSolvable();
+  void startIsSolvableWithout(SudokuCell& cell, int bit);
+  void startCountSolutions();
+
+  /* Continues the search until it is done, or the given time has been spent.
+   * Returns true when the search is done. A budget of zero means that there is
+   * no limit.
+   */
+  bool step(uint32_t budgetMicros);
+
+  /* As step(), but the search is continued until the given number of nodes
+   * has been tried. This makes it possible to interleave searches at a fine
+   * grain without the overhead of checking the time.
+   */
+  bool stepNodes(int numNodes);
+
+  bool isSearching() { return _searchPhase != SearchPhase::Idle; }
+  int numSolutionsFound() { return _numSolutionsFound; }
+
+  /* Abandons the search that is in progress, if any. When the search would
+   * have restored the puzzle, this is done as well.
+   */
+  void cancel();
+
+  /* Limits the effort of the next search to the given number of nodes and
+   * time. The time includes that between steps. A search that reaches a limit
+   * stops as if it found no (further) solutions, and isExhausted() then
+   * returns true. Zero means no limit (the default). Like the solution buffer,
+   * the limits are only used by the next search.
+   */
+  void setSearchLimits(int maxNodes, uint32_t maxMicros);
+
+  /* Makes searches stop, as when a limit is reached, once the given flag is
+   * set. It is checked for each node, so it can be set from another thread.
+   * Only the flag is shared, so checking it uses a relaxed load. Pass NULL to
+   * disable (the default).
+   */
+  void setCancelFlag(const std::atomic<bool>* flag) { _cancelFlag = flag; }
+
+  // Returns true when the last search was stopped by a limit or the cancel
+  // flag. Its outcome is then unknown.
+  bool isExhausted() { return _exhausted; }
+
+  /* Makes the next search store the solutions that it finds, up to the given
+   * maximum. Each takes numCells entries in the buffer, with the bit value of
+   * each cell. The buffer is only used by the next search.
+   */
+  void setSolutionBuffer(int* buffer, int maxSolutions);
+
+  /* Makes the solver try the given values first when branching. It expects a
+   * bit value for each cell. When searching for an alternative to a known
+   * solution, preferring its values tends to find a second solution sooner,
+   * as solutions often only differ in a few cells.
+   */
+  void setPreferredValues(const int* bits);
+
+  void setBranchOrder(BranchOrder order) { _branchOrder = order; }
+  BranchOrder branchOrder() { return _branchOrder; }
+
+  /* Makes the solver backtrack by restoring a snapshot of the puzzle state
+   * that it took before branching, instead of undoing each change. The buffer
+   * should provide a snapshot for each search depth. The solver reverts to
+   * undoing changes when it searches deeper than the buffer allows. Pass
+   * NULL to disable (the default).
+   */
+  void setSnapshotBuffer(SudokuState* buffer, int size);
+
+  // Enables the given optional propagation stages (a combination of the
+  // *Stage constants). By default none are enabled.
+  void setPropagationStages(int stages) { _propagationStages = stages; }
+  int propagationStages() { return _propagationStages; }
+
+  int numNodes() { return _numNodes; }
+  int numBacktracks() { return _numBacktracks; }
+
+#ifdef SOLVER_STATS
+  const SolverStats& stats() { return _stats; }
+  void resetStats() { _stats.reset(); }
+#endif
 };
 
 #endif
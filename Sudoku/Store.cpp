@@ -18,6 +18,8 @@ const uint8_t editingModeBit   = 0x01;
 const uint8_t autoFixBit       = 0x02; // Only used in editing mode
 const uint8_t multiSolutionBit = 0x04; // Only used in editing mode
 const uint8_t noSolutionBit    = 0x08; // Only used in editing mode
+// Both solution bits are set when the number of solutions was not yet known
+const uint8_t solutionBits     = multiSolutionBit | noSolutionBit;
 
 const int storeBufferSize = numCells + 1;
 uint8_t storeBuffer[storeBufferSize];
@@ -32,6 +34,9 @@ bool isStoreBufferEmpty() {
   return true;
 }
 
+// The first of the blocks that cache generated puzzles, one for each type
+const int generatedPuzzleBlockIndex = 4;
+
 int targetBlockIndex(bool userAction) {
   int blockIndex = sudoku.hyperConstraintsEnabled() ? 1 : 0;
   if (!userAction) {
@@ -40,16 +45,38 @@ int targetBlockIndex(bool userAction) {
   return blockIndex;
 }
 
-bool storePuzzle(bool userAction) {
+int generatedBlockIndex(bool hyper) {
+  return generatedPuzzleBlockIndex + (hyper ? 1 : 0);
+}
+
+void fillStoreBuffer(Sudoku& puzzle) {
   for (int y = 0; y < numRows; y++) {
     for (int x = 0; x < numCols; x++) {
-      uint8_t val = sudoku.getValue(x, y);
-      if (sudoku.isFixed(x, y)) {
+      uint8_t val = puzzle.getValue(x, y);
+      if (puzzle.isFixed(x, y)) {
         val |= cellIsFixedBit;
       }
       storeBuffer[x + y * numCols] = val;
     }
   }
+}
+
+bool readStoreBuffer(int blockIndex) {
+  // Clear buffer before reading. Although it should not be needed, better safe
+  // than sorry.
+  for (int i = 0; i < storeBufferSize; i++) {
+    storeBuffer[i] = (uint8_t)0;
+  }
+
+  if ( !gb.save.get(blockIndex, (void*)storeBuffer, storeBufferSize) ) {
+    return false;
+  }
+
+  return !isStoreBufferEmpty();
+}
+
+bool storePuzzle(bool userAction) {
+  fillStoreBuffer(sudoku);
 
   uint8_t mode = 0;
   if (editingPuzzle && !sudoku.solveInProgress()) {
@@ -60,7 +87,14 @@ bool storePuzzle(bool userAction) {
     if (sudoku.isAutoFixEnabled()) {
       mode |= autoFixBit;
     }
-    if (solutionCount == SolutionCount::Multiple) {
+    if (
+      solutionCount == SolutionCount::Computing ||
+      solutionCount == SolutionCount::Unknown
+    ) {
+      // Counting is tried again after loading
+      mode |= solutionBits;
+    }
+    else if (solutionCount == SolutionCount::Multiple) {
       mode |= multiSolutionBit;
     }
     else if (solutionCount == SolutionCount::None) {
@@ -74,20 +108,8 @@ bool storePuzzle(bool userAction) {
   );
 }
 
-bool loadPuzzle(bool userAction) {
-  // Clear buffer before reading. Although it should not be needed, better safe
-  // than sorry.
-  for (int i = 0; i < storeBufferSize; i++) {
-    storeBuffer[i] = (uint8_t)0;
-  }
-
-  if ( !gb.save.get(
-    targetBlockIndex(userAction), (void*)storeBuffer, storeBufferSize
-  )) {
-    return false;
-  }
-
-  if (isStoreBufferEmpty()) {
+bool loadPuzzleFromBlock(int blockIndex) {
+  if (!readStoreBuffer(blockIndex)) {
     return false;
   }
 
@@ -112,7 +134,10 @@ bool loadPuzzle(bool userAction) {
   editingPuzzle = (mode & editingModeBit) != 0;
   sudoku.setAutoFix((mode & autoFixBit) != 0);
   solutionCount = SolutionCount::One;
-  if ((mode & multiSolutionBit) != 0) {
+  if ((mode & solutionBits) == solutionBits) {
+    solutionCount = SolutionCount::Computing;
+  }
+  else if ((mode & multiSolutionBit) != 0) {
     solutionCount = SolutionCount::Multiple;
   }
   else if ((mode & noSolutionBit) != 0) {
@@ -122,3 +147,35 @@ bool loadPuzzle(bool userAction) {
   return true;
 }
 
+bool loadPuzzle(bool userAction) {
+  return loadPuzzleFromBlock(targetBlockIndex(userAction));
+}
+
+bool storeGeneratedPuzzle(Sudoku& puzzle) {
+  fillStoreBuffer(puzzle);
+  storeBuffer[numCells] = 0;
+
+  return gb.save.set(
+    generatedBlockIndex(puzzle.hyperConstraintsEnabled()),
+    (void*)storeBuffer, storeBufferSize
+  );
+}
+
+bool hasGeneratedPuzzle(bool hyper) {
+  return readStoreBuffer(generatedBlockIndex(hyper));
+}
+
+bool loadGeneratedPuzzle() {
+  bool hyper = sudoku.hyperConstraintsEnabled();
+  if (!loadPuzzleFromBlock(generatedBlockIndex(hyper))) {
+    return false;
+  }
+
+  // Each puzzle should only be used once
+  for (int i = 0; i < storeBufferSize; i++) {
+    storeBuffer[i] = (uint8_t)0;
+  }
+  gb.save.set(generatedBlockIndex(hyper), (void*)storeBuffer, storeBufferSize);
+
+  return true;
+}
@@ -4,5 +4,18 @@
  * Copyright 2018, Erwin Bonsma
  */
 
+#include "Sudoku.h"
+
 bool storePuzzle(bool userAction);
 bool loadPuzzle(bool userAction);
+
+/* Generated puzzles are cached, one per puzzle type, so that a new puzzle can
+ * be started without waiting for it to be generated.
+ */
+bool storeGeneratedPuzzle(Sudoku& puzzle);
+bool hasGeneratedPuzzle(bool hyper);
+
+/* Loads the cached puzzle for the current puzzle type, and removes it from the
+ * cache. Returns false if there was none.
+ */
+bool loadGeneratedPuzzle();
@@ -13,7 +13,10 @@
 #include "Progress.h"
 
 Stripper::Stripper(Sudoku& sudoku, Solver& solver)
-  : _s(sudoku), _solver(solver) {
+  : _s(sudoku), _solver(solver), _findSecondSolution(true), _minClues(0),
+    _maxCheckNodes(0), _grader(NULL), _band(anyDifficulty),
+    _phase(StripPhase::Done), _numFilledAtStart(0), _numClearAttempts(0),
+    _withinBand(false), _checking(false) {
 
   assertTrue( &(_solver.sudoku()) == &_s );
 
@@ -22,7 +25,7 @@ Stripper::Stripper(Sudoku& sudoku, Solver& solver)
   }
 }
 
-bool Stripper::hasOnePosition(int bit, int* cellIndices) {
+bool Stripper::hasOnePosition(int bit, const int* cellIndices) {
   int cnt = 0;
 
   for (int i = 0; i < constraintGroupSize; i++) {
@@ -38,10 +41,11 @@ bool Stripper::hasOnePosition(int bit, int* cellIndices) {
 }
 
 bool Stripper::hasOnePosition(int bit, SudokuCell& cell) {
-  int i = maxConstraintsPerCell;
-  if (!cell._possibleUsesLastConstraint) {
-    i--;
-  }
+  int i = (
+    cell._possibleUsesLastConstraint
+    ? maxConstraintsPerCell
+    : numBasicConstraintsPerCell
+  );
 
   while (--i >= 0) {
     int groupIndex = cell._constraintGroup[i];
@@ -54,9 +58,7 @@ bool Stripper::hasOnePosition(int bit, SudokuCell& cell) {
 }
 
 void Stripper::strip1() {
-  signalPuzzleGenerationProgress(1, progressBarLen);
-
-  for (int i = 0; i < numCells; i++) {
+  for (int i = 0; i < numCells && _s.numFilled() > _minClues; i++) {
     SudokuCell& cell = _s.cellAt(_p[i]);
     int bit = cell.getBitValue();
 
@@ -70,50 +72,181 @@ void Stripper::strip1() {
   }
 }
 
-void Stripper::strip2() {
-  int numFilledAtStart = _s.numFilled();
-  int numClearAttempts = 0;
-  signalPuzzleGenerationProgress(2, 2 + numFilledAtStart);
-
-  for (int i = 0; i < numCells; i++) {
-    SudokuCell& cell = _s.cellAt(_p[i]);
+bool Stripper::clearNextCell() {
+  while (_nextPos < numCells && _s.numFilled() > _minClues) {
+    int cellIndex = _p[_nextPos++];
+    SudokuCell& cell = _s.cellAt(cellIndex);
     int bit0 = cell.getBitValue();
     if (bit0 > 0) {
-      int bit = 1;
-      bool unique = true;
-      while (bit <= maxBitValue && unique) {
-        if (bit != bit0 && cell.isBitPossible(bit)) {
-          _s.setBitValue(cell, bit);
-          if (_solver.isSolvable()) {
-            unique = false;
-          }
-        }
-        bit <<= 1;
-      }
-      if (unique) {
-        _s.clearValue(cell);
-      } else {
-        // Restore cell to its original value
-        _s.setBitValue(cell, bit0);
-      }
+      _s.clearValue(cell);
+      _cellIndex = cellIndex;
+      _bit0 = bit0;
+      _numClearAttempts++;
+      return true;
+    }
+  }
 
-      numClearAttempts++;
-      signalPuzzleGenerationProgress(2 + numClearAttempts, 2 + numFilledAtStart);
+  return false;
+}
+
+bool Stripper::startCheck() {
+  if (_grader != NULL) {
+    if (_grader->grade() > _band.maxScore) {
+      _canRemainCleared = false; // Too hard
+      return true;
+    }
+    if (_grader->isSolved()) {
+      // The solution is unique, as it was deduced without guessing
+      _canRemainCleared = true;
+      return true;
     }
   }
 
-  signalPuzzleGenerationProgress(100, 100);
+  if (_findSecondSolution) {
+    _solver.setSearchLimits(_maxCheckNodes, 0);
+    _solver.startIsSolvableWithout(_s.cellAt(_cellIndex), _bit0);
+    return false;
+  }
+
+  _altBit = 0;
+  return tryNextAlternative();
 }
 
-void Stripper::strip() {
-  strip1();
-  debug("Solutions after strip1: %d\n", solver.countSolutions());
-  strip2();
-  debug("Solutions after strip2: %d\n", solver.countSolutions());
+bool Stripper::tryNextAlternative() {
+  SudokuCell& cell = _s.cellAt(_cellIndex);
+
+  for (int bit = (_altBit == 0) ? 1 : _altBit << 1; bit <= maxBitValue; bit <<= 1) {
+    if (bit != _bit0 && cell.isBitPossible(bit)) {
+      _s.setBitValue(cell, bit);
+      _altBit = bit;
+      _solver.setSearchLimits(_maxCheckNodes, 0);
+      _solver.startIsSolvable();
+      return false;
+    }
+  }
+
+  _canRemainCleared = true;
+  return true;
 }
 
-void Stripper::randomStrip() {
-  permute(_p, numCells);
-  strip();
+bool Stripper::continueCheck(uint32_t budgetMicros) {
+  while (_solver.step(budgetMicros)) {
+    if (_solver.isExhausted()) {
+      // Uniqueness was not proven, so the value is kept
+      _canRemainCleared = false;
+      return true;
+    }
+
+    bool solvable = (_solver.numSolutionsFound() > 0);
+    if (_findSecondSolution || solvable) {
+      _canRemainCleared = !solvable;
+      return true;
+    }
+
+    _s.clearValue(_s.cellAt(_cellIndex));
+    if (tryNextAlternative()) {
+      return true;
+    }
+    if (budgetMicros != 0) {
+      // Leave the search for this alternative to the next invocation
+      return false;
+    }
+  }
+
+  return false;
 }
 
+bool Stripper::strip2(uint32_t budgetMicros) {
+  if (!_checking) {
+    if (!clearNextCell()) {
+      return true;
+    }
+    _checking = !startCheck();
+  }
+
+  if (_checking) {
+    if (!continueCheck(budgetMicros)) {
+      return false;
+    }
+    _checking = false;
+  }
+
+  if (!_canRemainCleared) {
+    // Restore cell to its original value
+    _s.setBitValue(_s.cellAt(_cellIndex), _bit0);
+  }
+
+  return false;
+}
+
+void Stripper::setDifficultyBand(Grader* grader, const DifficultyBand& band) {
+  assertTrue(grader == NULL || &(grader->sudoku()) == &_s);
+
+  _grader = grader;
+  _band = band;
+}
+
+void Stripper::startStrip() {
+  for (int i = 0; i < numCells; i++) {
+    _solution[i] = _s.cellAt(i).getBitValue();
+  }
+  _solver.setPreferredValues(_solution);
+
+  _phase = StripPhase::Strip1;
+  _withinBand = false;
+  _checking = false;
+}
+
+void Stripper::startRandomStrip() {
+  permute(_p, numCells, _solver.random());
+  startStrip();
+}
+
+bool Stripper::stripStep(uint32_t budgetMicros) {
+  switch (_phase) {
+    case StripPhase::Strip1:
+      strip1();
+      debug("Solutions after strip1: %d\n", _solver.countSolutions());
+      if (_grader != NULL && _grader->grade() > _band.maxScore) {
+        // Stripping only makes it harder
+        _phase = StripPhase::Done;
+        return true;
+      }
+
+      _nextPos = 0;
+      _numFilledAtStart = _s.numFilled();
+      _numClearAttempts = 0;
+      _phase = StripPhase::Strip2;
+      return false;
+
+    case StripPhase::Strip2:
+      if (!strip2(budgetMicros)) {
+        return false;
+      }
+      debug("Solutions after strip2: %d\n", _solver.countSolutions());
+
+      _withinBand = _grader == NULL || _band.contains(_grader->grade());
+      _phase = StripPhase::Done;
+      return true;
+
+    default:
+      return true;
+  }
+}
+
+bool Stripper::strip() {
+  startStrip();
+
+  signalPuzzleGenerationProgress(1, progressBarLen);
+  while (!stripStep()) {
+    signalPuzzleGenerationProgress(2 + _numClearAttempts, 2 + _numFilledAtStart);
+  }
+  signalPuzzleGenerationProgress(100, 100);
+
+  return _withinBand;
+}
+
+bool Stripper::randomStrip() {
+  permute(_p, numCells, _solver.random());
+  return strip();
+}
@@ -7,11 +7,20 @@
 #ifndef __STRIPPER_INCLUDED
 #define __STRIPPER_INCLUDED
 
+#include "Grader.h"
 #include "Solver.h"
 #include "Sudoku.h"
 
 //------------------------------------------------------------------------------
 
+enum class StripPhase : int {
+  Strip1,
+  Strip2,
+  Done
+};
+
+//------------------------------------------------------------------------------
+
 /* Clears values from a Sudoku that are not needed to ensure it has a unique
  * solution until no more values can be cleared.
  */
@@ -24,26 +33,134 @@ class Stripper {
   // Permutation
   int _p[numCells];
 
+  // The solution of the puzzle, i.e. its values before stripping started
+  int _solution[numCells];
+
+  // When set, strip2 checks if a value can be cleared by searching once for
+  // a solution without that value, instead of trying each alternative value.
+  bool _findSecondSolution;
+
+  // Stripping stops when only this many values remain
+  int _minClues;
+
+  // The maximum number of solver nodes per check, or zero for no limit
+  int _maxCheckNodes;
+
+  // Optional grader, used to keep the difficulty within _band
+  Grader* _grader;
+  DifficultyBand _band;
+
+  // The progress of the current strip, see stripStep()
+  StripPhase _phase;
+  // The next position in _p to try in the second phase
+  int _nextPos;
+  int _numFilledAtStart;
+  int _numClearAttempts;
+  bool _withinBand;
+
+  // The cell that the second phase is trying to clear, and its original value
+  int _cellIndex;
+  int _bit0;
+  // When trying each alternative value, the one that is being tried
+  int _altBit;
+  // Set while the solver checks if the cell can remain cleared
+  bool _checking;
+  // The outcome of the check
+  bool _canRemainCleared;
+
 protected:
-  bool hasOnePosition(int bit, int* cellIndices);
+  bool hasOnePosition(int bit, const int* cellIndices);
 
   bool hasOnePosition(int bit, SudokuCell& cell);
 
+  // Clears the next cell that the second phase should try. Returns false when
+  // there are no more.
+  bool clearNextCell();
+
+  /* Starts checking if the cell that has just been cleared can remain so. This
+   * is the case when the solution is still unique and the puzzle did not get
+   * too hard. Returns true when the outcome is already known, in which case it
+   * is stored in _canRemainCleared. Otherwise a solver search is started, and
+   * continueCheck() should be invoked until it returns true.
+   */
+  bool startCheck();
+  bool continueCheck(uint32_t budgetMicros);
+
+  // Sets the cell to the next alternative value and starts searching for a
+  // solution. Returns true when there are no more alternatives.
+  bool tryNextAlternative();
+
   /* First stripping phase. All cells are cleared whose value can be directly
    * inferred given the other filled cells.
    */
   void strip1();
 
   /* Second stripping phase. It clears all cells whose value is not required to
-   * ensure the solution remains unique.
+   * ensure the solution remains unique, or to keep the puzzle within the
+   * difficulty band. Each invocation tries to clear one cell, or continues
+   * doing so when the previous invocation ran out of time. Returns true when
+   * there are no more cells to try.
    */
-  void strip2();
+  bool strip2(uint32_t budgetMicros);
 
 public:
   Stripper(Sudoku& sudoku, Solver& solver);
 
-  void strip();
-  void randomStrip();
+  void setFindSecondSolution(bool enabled) { _findSecondSolution = enabled; }
+
+  /* Stops stripping when the given number of values remain. The solution is
+   * still unique then, but the puzzle is not minimal. Proving uniqueness gets
+   * very expensive for sparse large puzzles, so this keeps their generation
+   * feasible. By default there is no minimum.
+   */
+  void setMinClues(int minClues) { _minClues = minClues; }
+
+  /* Limits each check of the second phase to the given number of solver
+   * nodes. When a check runs out, the value is kept, as the solution may not
+   * be unique without it. This bounds the time per clear attempt, but the
+   * puzzle is then not always minimal. By default there is no limit.
+   */
+  void setMaxCheckNodes(int maxNodes) { _maxCheckNodes = maxNodes; }
+
+  /* Makes stripping aim for the given difficulty band, as scored by the grader
+   * (which should grade the same puzzle). Values are not cleared when that
+   * would make the puzzle too hard. Puzzles that end up too easy are not
+   * prevented, but are signalled so they can be discarded. Pass NULL to
+   * disable (the default).
+   *
+   * Solving the puzzle without guessing proves that its solution is unique.
+   * So when the band excludes guessing, the solver is rarely needed, which
+   * makes stripping faster.
+   */
+  void setDifficultyBand(Grader* grader, const DifficultyBand& band);
+
+  /* Strips the puzzle. Returns false when its difficulty is outside the band.
+   * When the puzzle is already too hard after the first phase, stripping is
+   * aborted.
+   */
+  bool strip();
+  bool randomStrip();
+
+  /* Incremental stripping, so that puzzles can be generated a bit at a time,
+   * e.g. in the background. After starting, each call of stripStep() performs
+   * the first phase or a single clear attempt of the second phase, and
+   * returns true once stripping is done. Unlike strip(), it does not signal
+   * progress.
+   *
+   * With a time budget, a clear attempt is suspended when the budget is used,
+   * and resumed by the next call. The budget can be exceeded by the work that
+   * is not done by the solver, e.g. the first phase, which is small.
+   */
+  void startStrip();
+  void startRandomStrip();
+  bool stripStep(uint32_t budgetMicros = 0);
+
+  // Returns true when a completed strip resulted in a puzzle within the band
+  bool isWithinBand() { return _withinBand; }
+
+  StripPhase phase() { return _phase; }
+  int numFilledAtStart() { return _numFilledAtStart; }
+  int numClearAttempts() { return _numClearAttempts; }
 };
 
 #endif
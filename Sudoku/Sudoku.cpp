@@ -10,86 +10,10 @@
 #include "Sudoku.h"
 #include "Utils.h"
 
-// Constraint tables
-int constraintCells[numConstraintGroups][constraintGroupSize];
-
 bool isPartOfHyperBox(int x, int y) {
   return ((x + 3) % 4 < 3) && ((y + 3) % 4 < 3);
 }
 
-void initConstraintTables() {
-  int groupIndex = 0;
-
-  // Column constraints
-  for (int i = 0; i < numCols; i++) {
-    int cellIndex = i;
-    for (int j = 0; j < constraintGroupSize; j++) {
-      constraintCells[groupIndex][j] = cellIndex;
-      cellIndex += 9;
-    }
-    groupIndex++;
-  }
-
-  // Row constraints
-  for (int i = 0; i < numRows; i++) {
-    int cellIndex = i * numCols;
-    for (int j = 0; j < constraintGroupSize; j++) {
-      constraintCells[groupIndex][j] = cellIndex;
-      cellIndex++;
-    }
-    groupIndex++;
-  }
-
-  // Box constraints
-  for (int i = 0; i < numBoxes; i++) {
-    int cellIndex = 3 * (i % 3 + (i / 3) * 9);
-    for (int j = 0; j < constraintGroupSize; j++) {
-      constraintCells[groupIndex][j] = cellIndex;
-      if (j % 3 == 2) {
-        cellIndex += 7;
-      } else {
-        cellIndex++;
-      }
-    }
-    groupIndex++;
-  }
-
-  // Hyper-box constraints
-  // First the explicit ones
-  for (int i = 0; i < 4; i++) {
-    int x = 1 + (i % 2) * 4;
-    int y = 1 + (i / 2) * 4;
-    int cellIndex = x + y * numCols;
-
-    assertTrue(isPartOfHyperBox(x, y));
-    for (int j = 0; j < constraintGroupSize; j++) {
-      constraintCells[groupIndex][j] = cellIndex;
-      if (j % 3 == 2) {
-        cellIndex += 7;
-      } else {
-        cellIndex++;
-      }
-    }
-    groupIndex++;
-  }
-  // Now the four ones these imply
-  for (int i = 0; i < 2; i++) {
-    for (int j = 0; j < constraintGroupSize; j++) {
-      int x = (j % 3) * 4;
-      int y = 1 + i * 4 + (j / 3);
-      constraintCells[groupIndex][j] = x + y * numCols;
-      constraintCells[groupIndex + 1][j] = y + x * numCols;
-    }
-    groupIndex += 2;
-  }
-  // Now the last one
-  for (int j = 0; j < constraintGroupSize; j++) {
-    int x = (j % 3) * 4;
-    int y = (j / 3) * 4;
-    constraintCells[groupIndex][j] = x + y * numCols;
-  }
-}
-
 //------------------------------------------------------------------------------
 // SudokuCell
 
@@ -101,17 +25,21 @@ void SudokuCell::init(Sudoku* parent, int cellIndex) {
   int row = (_index - col) / numCols;
   _constraintGroup[0] = col;
   _constraintGroup[1] = numCols + row;
-  _constraintGroup[2] = numCols + numRows + col / 3 + 3 * (row / 3);
+  _constraintGroup[2] = numCols + numRows + col / boxSize + boxSize * (row / boxSize);
+
+  if (!hyperSupported) {
+    return;
+  }
 
   // Determine the hyper-constraint group that this cell belongs to by searching
   // for the group that contains this cell. Due to their more irregular
   // structure, it is harder to calculate this from the cell's position.
   int i = numCols + numRows + numBoxes;
   while (i < numConstraintGroups) {
-    int* cellIndices = constraintCells[i];
+    const int* cellIndices = constraintCells[i];
     for (int j = 0; j < constraintGroupSize; j++) {
       if (cellIndices[j] == _index) {
-        _constraintGroup[3] = i;
+        _constraintGroup[maxConstraintsPerCell - 1] = i;
         return;
       }
     }
@@ -121,14 +49,13 @@ void SudokuCell::init(Sudoku* parent, int cellIndex) {
 }
 
 void SudokuCell::reset() {
-  _value = 0;
   _fixed = false;
 
   if (_parent->hyperConstraintsEnabled()) {
     // The last constraint only applies when hyper-boxes are enabled and this
     // cell is part of one of the four explicit hyper boxes.
     _allowedUsesLastConstraint = (
-      _constraintGroup[3] < numExplicitConstraintGroups
+      _constraintGroup[maxConstraintsPerCell - 1] < numExplicitConstraintGroups
     );
     _possibleUsesLastConstraint = true;
   } else {
@@ -137,18 +64,6 @@ void SudokuCell::reset() {
   }
 }
 
-int SudokuCell::bitMask(bool applyLastConstraint) {
-  int m = (
-    _parent->_constraintMask[_constraintGroup[0]] &
-    _parent->_constraintMask[_constraintGroup[1]] &
-    _parent->_constraintMask[_constraintGroup[2]]
-  );
-  if (applyLastConstraint) {
-    m &= _parent->_constraintMask[_constraintGroup[3]];
-  }
-  return m;
-}
-
 bool SudokuCell::isBitAllowed(int bit) {
   return (allowedBitMask() & bit) != 0;
 }
@@ -158,14 +73,14 @@ bool SudokuCell::isBitPossible(int bit) {
 }
 
 bool SudokuCell::hasOneAllowedValue() {
-  assertTrue(_value == 0);
+  assertTrue(!isSet());
   int m = allowedBitMask();
   // Note: x & (x - 1) clears the right-most bit
   return (m & (m - 1)) == 0;
 }
 
 bool SudokuCell::hasOnePossibleValue() {
-  assertTrue(_value == 0);
+  assertTrue(!isSet());
   int m = possibleBitMask();
   // Note: x & (x - 1) clears the right-most bit
   return (m & (m - 1)) == 0;
@@ -183,18 +98,21 @@ void Sudoku::init() {
 }
 
 void Sudoku::reset(bool hyperConstraints) {
+  assertTrue(hyperSupported || !hyperConstraints);
+
   _hyperConstraints = hyperConstraints;
   _autoFix = false;
 
-  _numFilled = 0;
+  _state.numFilled = 0;
   _numFixed = 0;
 
   for (int i = 0; i < numCells; i++) {
+    _state.values[i] = 0;
     _cells[i].reset();
   }
 
   for (int i = 0; i < numConstraintGroups; i++) {
-    _constraintMask[i] = maxBitMask;
+    _state.constraintMask[i] = maxBitMask;
   }
 }
 
@@ -209,11 +127,42 @@ void Sudoku::reset(Sudoku& sudoku) {
   }
 }
 
+bool Sudoku::reset(bool hyperConstraints, const uint8_t* values) {
+  reset(hyperConstraints);
+
+  for (int i = 0; i < numCells; i++) {
+    int value = values[i];
+    if (value == 0) {
+      continue;
+    }
+    if (value > numValues) {
+      return false;
+    }
+
+    SudokuCell& cell = _cells[i];
+    int bit = valueToBit(value);
+    if (!cell.isBitAllowed(bit)) {
+      return false;
+    }
+
+    // As setBitValue(), but without the bookkeeping of fixed cells, which
+    // the reset cleared
+    _state.values[i] = bit;
+    _state.numFilled++;
+    for (int j = 0; j < maxConstraintsPerCell; j++) {
+      int groupIndex = cell._constraintGroup[j];
+      _state.constraintMask[groupIndex] &= ~bit;
+    }
+  }
+
+  return true;
+}
+
 void Sudoku::updateBitMasks(SudokuCell& cell, int bit, int (*updateFun)(int, int)) {
   for (int i = 0; i < maxConstraintsPerCell; i++) {
     int groupIndex = cell._constraintGroup[i];
 
-    _constraintMask[groupIndex] = (*updateFun)(_constraintMask[groupIndex], bit);
+    _state.constraintMask[groupIndex] = (*updateFun)(_state.constraintMask[groupIndex], bit);
   }
 }
 
@@ -222,11 +171,11 @@ void Sudoku::setValue(int x, int y, int value) {
 }
 
 void Sudoku::clearValue(SudokuCell& cell) {
-  int oldBit = cell._value;
+  int oldBit = cell.getBitValue();
   assertTrue(oldBit > 0);
 
-  _numFilled--;
-  cell._value = 0;
+  _state.numFilled--;
+  _state.values[cell._index] = 0;
 
   // Unusual, but can happen while puzzle is being edited
   if (cell._fixed) {
@@ -246,8 +195,8 @@ void Sudoku::setBitValue(SudokuCell& cell, int bit) {
     clearValue(cell);
   }
 
-  _numFilled++;
-  cell._value = bit;
+  _state.numFilled++;
+  _state.values[cell._index] = bit;
   if (_autoFix || wasFixed) {
     cell._fixed = true;
     _numFixed++;
@@ -286,12 +235,12 @@ bool Sudoku::nextValue(SudokuCell& cell) {
   return false;
 }
 
-AutoSetResult Sudoku::autoSet(SudokuCell& cell) {
+AutoSetResult Sudoku::autoSet(SudokuCell& cell, int excludedBits) {
   if (cell.isSet()) {
     return AutoSetResult::AlreadySet;
   }
 
-  int m = cell.possibleBitMask();
+  int m = cell.possibleBitMask() & ~excludedBits;
   if (m == 0) {
     return AutoSetResult::Stuck;
   }
@@ -368,10 +317,10 @@ void Sudoku::dump() {
 #ifdef DEVELOPMENT
   for (int i = 0; i < numCells; i++) {
     int val = bitToValue(cellAt(i).getBitValue());
-    if (i % 9 == 8) {
+    if (i % numCols == numCols - 1) {
       debug("%d\n", val);
     }
-    else if (i % 3 == 2) {
+    else if (i % boxSize == boxSize - 1) {
       debug("%d | ", val);
     }
     else {
@@ -12,14 +12,35 @@
 
 bool isPartOfHyperBox(int x, int y);
 
-void initConstraintTables();
-
 class Sudoku;
 
+// Storage type of cell values and masks in SudokuState. It needs a bit for
+// each value.
+#if BOX_SIZE > 4
+typedef uint32_t CompactMask;
+#else
+typedef uint16_t CompactMask;
+#endif
+
+/* The state of a puzzle that changes while it is being solved. It is kept
+ * compact (and trivially copyable) so that it fits in a few cache lines and
+ * can cheaply be saved and restored.
+ */
+struct SudokuState {
+  // The (bit) value of each cell, zero when the cell is not set
+  CompactMask values[numCells];
+
+  // Checks for each constraint group the values that still need to be filled.
+  CompactMask constraintMask[numConstraintGroups];
+
+  uint16_t numFilled;
+};
+
 class SudokuCell {
   friend class Sudoku;
   friend class Solver;
   friend class Stripper;
+  friend class Grader;
 
   // Index of cell
   int _index;
@@ -27,7 +48,6 @@ class SudokuCell {
   Sudoku* _parent;
 
 protected:
-  int _value;
   bool _fixed;
 
   // The constraint groups that this cell is part of
@@ -36,6 +56,10 @@ protected:
   bool _allowedUsesLastConstraint;
   bool _possibleUsesLastConstraint;
 
+  /* Mask with the values that are still missing in all the cell's constraint
+   * groups, optionally ignoring the last (hyper-box) one. It is inlined so
+   * that callers that pass a constant only check the groups that they need.
+   */
   int bitMask(bool applyLastConstraint);
 
   /* Mask that indicates what (bit) values are allowed.
@@ -62,8 +86,8 @@ public:
   bool hasOneAllowedValue();
   bool hasOnePossibleValue();
 
-  int getBitValue() { return _value; }
-  bool isSet() { return _value != 0; }
+  int getBitValue();
+  bool isSet() { return getBitValue() != 0; }
   bool isFixed() { return _fixed; }
 
   int index() { return _index; }
@@ -86,13 +110,11 @@ class Sudoku {
 
   SudokuCell _cells[numCells];
 
-  // Checks for each constraint group the values that still need to be filled.
-  int _constraintMask[numConstraintGroups];
+  SudokuState _state;
 
   bool _autoFix;
   bool _hyperConstraints;
 
-  int _numFilled;
   int _numFixed;
 
 public:
@@ -103,15 +125,22 @@ public:
   void reset(bool hyperConstraints);
   void reset(Sudoku& sudoku);
 
+  /* Also sets the given values, one per cell in row-major order with zero for
+   * empty cells. This is faster than setting each value separately. Returns
+   * false when a value is out of range or violates one of the constraints.
+   * The puzzle is then only partly set.
+   */
+  bool reset(bool hyperConstraints, const uint8_t* values);
+
   // Getters
   SudokuCell& cellAt(int x, int y) { return _cells[x + y * numCols]; }
   SudokuCell& cellAt(int cellIndex) { return _cells[cellIndex]; }
   int getValue(int x, int y);
   bool isFixed(int x, int y);
   bool isSet(int x, int y);
-  bool isSolved() { return _numFilled == numCells; }
-  bool solveInProgress() { return _numFixed > 0 && _numFilled > _numFixed; }
-  int numFilled() { return _numFilled; }
+  bool isSolved() { return _state.numFilled == numCells; }
+  bool solveInProgress() { return _numFixed > 0 && _state.numFilled > _numFixed; }
+  int numFilled() { return _state.numFilled; }
 
   // Setters
   void setValue(int x, int y, int value);
@@ -140,10 +169,32 @@ public:
   bool nextValue(SudokuCell& cell);
 
   /* Sets the given cell if it only has one possible value and is not yet set.
+   * Values in "excludedBits" are not considered possible.
+   */
+  AutoSetResult autoSet(SudokuCell& cell, int excludedBits = 0);
+
+  /* Saves and restores the values and constraint masks. Restoring is only
+   * valid when the fixed cells did not change in between.
    */
-  AutoSetResult autoSet(SudokuCell& cell);
+  void saveState(SudokuState& state) { state = _state; }
+  void restoreState(const SudokuState& state) { _state = state; }
 
   void dump();
 };
 
+inline int SudokuCell::getBitValue() { return _parent->_state.values[_index]; }
+
+inline int SudokuCell::bitMask(bool applyLastConstraint) {
+  const CompactMask* masks = _parent->_state.constraintMask;
+  int m = (
+    masks[_constraintGroup[0]] &
+    masks[_constraintGroup[1]] &
+    masks[_constraintGroup[2]]
+  );
+  if (applyLastConstraint) {
+    m &= masks[_constraintGroup[maxConstraintsPerCell - 1]];
+  }
+  return m;
+}
+
 #endif
@@ -10,9 +10,17 @@
 #include "Globals.h"
 #include "Drawing.h"
 #include "Store.h"
+#include "Profiling.h"
 #include "Progress.h"
+#include "PuzzleCache.h"
+#include "PuzzleGenerator.h"
+#include "SolutionTracker.h"
 #include "Strings.h"
 
+#if BOX_SIZE != 3
+#error "The game only supports 9x9 puzzles"
+#endif
+
 // Globals
 int cursorCol = 4;
 int cursorRow = 4;
@@ -25,9 +33,19 @@ Stripper stripper(sudoku, solver);
 SolutionCount solutionCount;
 
 // Locals
-int generateNewPuzzleCountdown;
+PuzzleGenerator generator(sudoku, solver, stripper);
+SolutionTracker solutionTracker(sudoku);
 bool wasSolved = false;
 
+// The time in each frame that is spent on generating a puzzle while the player
+// waits for it. The rest of the frame is left for showing progress and
+// playing sound.
+const uint32_t generationBudgetMicros = 30000;
+
+// The time in each frame that can be spent on counting the solutions of the
+// puzzle that is being edited. Puzzles are not cached meanwhile.
+const uint32_t countBudgetMicros = 15000;
+
 const Gamebuino_Meta::Sound_FX sfxNoValue[] = {
   { Gamebuino_Meta::Sound_FX_Wave::SQUARE, 0, 128, 0, 0, 75, 2 }
 };
@@ -46,39 +64,27 @@ void resetPuzzle() {
   sudoku.resetValues();
 }
 
-/* Initiates puzzle generation.
+/* Initiates puzzle generation. This is only needed when there is no cached
+ * puzzle (see PuzzleCache.h).
  *
- * As this takes several frames, it should not be executed as part of normal
- * flow. It will invoke gb.update() periodically to show progress. However, it
- * should not be relied upon that this is done often enough. Playing sounds may
- * therefore be distorted and are therefore stopped.
+ * As this takes several frames, the generator is invoked from loop() with a
+ * limited time budget each frame, until the puzzle is ready.
  */
 void startPuzzleGeneration() {
-  gb.sound.stop(0); // Stop any sound from playing (e.g. OK sound from menu)
-
-  // Reset the puzzle
-  sudoku.reset(sudoku.hyperConstraintsEnabled());
-
-  // Solve it to generate a (random) solution
-  assertTrue(solver.randomSolve());
-
-  // Now clear as many values as possible to create the actual puzzle
-  stripper.randomStrip();
+  // The generator repeats until the puzzle is within the stripper's difficulty
+  // band (which by default accepts all)
+  generator.start(sudoku.hyperConstraintsEnabled());
+}
 
+void finishPuzzleGeneration() {
   sudoku.fixValues();
   solutionCount = SolutionCount::One;
   editingPuzzle = false;
 }
 
-void generateNewPuzzle(bool delay) {
-  if (delay) {
-    // Initiate puzzle creation, but wait a few frames before generating puzzle,
-    // so OK sound is not (too) abruptly aborted
-    generateNewPuzzleCountdown = 8;
-  } else {
-    // Trigger puzzle generation in 2nd frame. This way generate message is
-    // still shown first
-    generateNewPuzzleCountdown = 2;
+void generateNewPuzzle() {
+  if (!takeCachedPuzzle()) {
+    startPuzzleGeneration();
   }
 }
 
@@ -90,6 +96,9 @@ void createNewPuzzle() {
   editingPuzzle = true;
 }
 
+// In frames. The popup is drawn over the puzzle.
+const int popupDuration = 40;
+
 #define NUM_MENU_ENTRIES 7
 const char* menuEntries[NUM_MENU_ENTRIES];
 
@@ -110,6 +119,17 @@ int initMenuEntries() {
   return i;
 }
 
+/* Starts counting the solutions of the edited puzzle. The count is often known
+ * right away. Otherwise it is computed by updateSolutionCount(), and auto-fix
+ * remains as it is meanwhile.
+ */
+void startSolutionCount() {
+  solutionCount = solutionTracker.puzzleChanged();
+  if (solutionCount != SolutionCount::Computing) {
+    sudoku.setAutoFix(solutionCount != SolutionCount::One);
+  }
+}
+
 void mainMenu() {
   int numItems = initMenuEntries();
   uint8_t entry = gb.gui.menu(
@@ -119,19 +139,21 @@ void mainMenu() {
   switch (entry) {
     case 0:
       if (storePuzzle(true)) {
-        gb.gui.popup(puzzleSaved, 40);
+        gb.gui.popup(puzzleSaved, popupDuration);
+        invalidateDisplay(popupDuration);
       }
       break;
     case 1:
       if (!loadPuzzle(true)) {
-        gb.gui.popup(loadFailed, 40);
+        gb.gui.popup(loadFailed, popupDuration);
+        invalidateDisplay(popupDuration);
       }
       break;
     case 2:
       resetPuzzle();
       break;
     case 3:
-      generateNewPuzzle(true);
+      generateNewPuzzle();
       break;
     case 4:
       createNewPuzzle();
@@ -142,10 +164,16 @@ void mainMenu() {
       sudoku.reset(!sudoku.hyperConstraintsEnabled());
       if (!loadPuzzle(false)) {
         // No puzzle was auto-stored yet. Generate one.
-        generateNewPuzzle(true);
+        generateNewPuzzle();
       }
       break;
   }
+
+  if (solutionCount == SolutionCount::Computing) {
+    // The puzzle may have been replaced, e.g. by loading one whose solutions
+    // were still being counted
+    startSolutionCount();
+  }
 }
 
 // Returns true if cursor did move.
@@ -202,12 +230,13 @@ bool handleCellChange() {
 }
 
 void update() {
+  PROFILE(ProfilePhase::Update);
+
   handleCursorMove();
 
   if (handleCellChange()) {
     if (editingPuzzle && !sudoku.solveInProgress()) {
-      solutionCount = solver.countSolutions();
-      sudoku.setAutoFix(solutionCount != SolutionCount::One);
+      startSolutionCount();
     }
   }
 
@@ -221,6 +250,18 @@ void update() {
   wasSolved = sudoku.isSolved();
 }
 
+/* Continues counting the solutions of the edited puzzle. It uses the solver of
+ * the puzzle cache, which is suspended meanwhile.
+ */
+void updateSolutionCount() {
+  PROFILE(ProfilePhase::Solver);
+
+  if (solutionTracker.step(suspendPuzzleCache(), countBudgetMicros)) {
+    solutionCount = solutionTracker.solutionCount();
+    sudoku.setAutoFix(solutionCount != SolutionCount::One);
+  }
+}
+
 void setup() {
   gb.begin();
 
@@ -255,28 +296,43 @@ void setup() {
   SerialUSB.printf("\n");
 #endif
 
-  initConstraintTables();
+  initProfiling();
+
   sudoku.init();
+  solver.seedRandom(rand());
+  initPuzzleCache();
 
-  generateNewPuzzle(false);
+  generateNewPuzzle();
 }
 
 void loop() {
   while(!gb.update());
-  gb.display.clear();
+  startProfiledFrame();
   gb.lights.clear();
 
-  if (generateNewPuzzleCountdown > 0) {
-    generateNewPuzzleCountdown--;
+  if (generator.isBusy()) {
+    gb.display.clear();
+    bool done;
+    {
+      PROFILE(ProfilePhase::Generation);
+      done = generator.step(generationBudgetMicros);
+    }
+    drawPuzzleGenerationProgress(generator.progress(progressBarLen), progressBarLen);
 
-    if (generateNewPuzzleCountdown == 0) {
-      startPuzzleGeneration();
-    } else {
-      signalPuzzleGenerationProgress(0, 100);
+    if (done) {
+      finishPuzzleGeneration();
     }
   }
   else {
     draw(sudoku);
     update();
+    if (solutionCount == SolutionCount::Computing) {
+      updateSolutionCount();
+    } else {
+      updatePuzzleCache();
+    }
   }
+
+  drawProfilingOverlay();
+  endProfiledFrame();
 }
@@ -8,14 +8,16 @@
 
 #include "Utils.h"
 
-void initDebugLog() {
-  SerialUSB.begin(9600);
-  while (!SerialUSB);
+int Random::next(int n) {
+  _state ^= _state << 13;
+  _state ^= _state >> 17;
+  _state ^= _state << 5;
+  return (int)(_state % (uint32_t)n);
 }
 
-void permute(int* list, int len) {
+void permute(int* list, int len, Random& random) {
   for (int i = 0; i < len; i++) {
-    int j = i + rand() % (len - i);
+    int j = i + random.next(len - i);
     if (i != j) {
       int v = list[i];
       list[i] = list[j];
@@ -32,6 +34,16 @@ int clearBit(int mask, int bit) {
   return (mask & ~bit);
 }
 
+int countBits(int mask) {
+  int count = 0;
+  while (mask != 0) {
+    // Clear the right-most bit
+    mask &= mask - 1;
+    count++;
+  }
+  return count;
+}
+
 int bitToValue(int bit) {
   int value = 0;
   while (bit > 0) {
@@ -44,26 +56,3 @@ int bitToValue(int bit) {
 int valueToBit(int value) {
   return 1 << (value - 1);
 }
-
-void assertFailed(const char *function, const char *file, int lineNo, const char *expression) {
-  if (SerialUSB) {
-    SerialUSB.println("=== ASSERT FAILED ===");
-    SerialUSB.println(function);
-    SerialUSB.println(file);
-    SerialUSB.println(lineNo, DEC);
-    SerialUSB.println(expression);
-    SerialUSB.flush();
-  }
-
-  while (1) {
-    if (gb.update()) {
-      gb.display.clear();
-      gb.display.setColor(RED);
-      gb.display.println("Assert failed:");
-      gb.display.println(function);
-      gb.display.println(file);
-      gb.display.println(lineNo, DEC);
-      gb.display.println(expression);
-    }
-  }
-}
@@ -7,22 +7,55 @@
 #ifndef __UTILS_INCLUDED
 #define __UTILS_INCLUDED
 
+#include <stdint.h>
+
 // Comment out next line to enable development features
 //#define DEVELOPMENT
 
+// Comment out next line to measure where the time goes each frame (see
+// Profiling.h)
+//#define PROFILING
+
+// Comment out next line to collect search statistics in the solver (see
+// Solver.h). The host tools enable it from their Makefile.
+//#define SOLVER_STATS
+
 void initDebugLog();
 
+// Time in microseconds, from an arbitrary start. It wraps around.
+uint32_t timeMicros();
+
 #ifdef DEVELOPMENT
   #define debug(format, ...) SerialUSB.printf(format, __VA_ARGS__);
 #else
   #define debug(format, ...)
 #endif
 
-void permute(int* list, int len);
+/* Pseudo-random number generator (xorshift32). Unlike rand(), each instance
+ * has its own state, so that multiple puzzle generators can run independently
+ * (e.g. in different threads).
+ */
+class Random {
+  uint32_t _state;
+
+public:
+  Random() : _state(1) {}
+
+  // The seed can be any value (zero is mapped to a non-zero state)
+  void seed(uint32_t seed) { _state = (seed != 0) ? seed : 0x9e3779b9; }
+
+  // Returns a value in the range [0, n)
+  int next(int n);
+};
+
+void permute(int* list, int len, Random& random);
 
 int setBit(int mask, int bit);
 int clearBit(int mask, int bit);
 
+// Returns the number of bits that are set
+int countBits(int mask);
+
 int bitToValue(int bit);
 int valueToBit(int value);
 
@@ -4,13 +4,15 @@
  * Copyright 2018, Erwin Bonsma
  */
 
-/* Can store four puzzles:
+/* Can store six puzzles:
  * 0: Normal sudoku, stored by user
  * 1: Hyper sudoku, stored by user
  * 2: Normal sudoku, stored when enabling hyper mode
  * 3: Hyper sudoku, stored when disabling hyper mode
+ * 4: Normal sudoku, generated in the background for the next new puzzle
+ * 5: Hyper sudoku, generated in the background for the next new puzzle
  */
-#define SAVEBLOCK_NUM 4
+#define SAVEBLOCK_NUM 6
 
 // Should match storeBufferSize in Store.cpp
 #define SAVECONF_DEFAULT_BLOBSIZE 82
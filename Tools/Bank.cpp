@@ -0,0 +1,257 @@
+/*
+ * Sudoku, a Gamebuino game
+ *
+ * Copyright 2018, Erwin Bonsma
+ */
+
+/* Maintains puzzle banks (see PuzzleBank.h).
+ *
+ * Usage: bank info <bank>
+ *        bank sample [-n count] [-s seed] [-v] <bank>
+ *        bank dump [-v] <bank>
+ *        bank import [-y] <bank> [file...]
+ *
+ *   info    Reports the number of puzzles per type and per hardest technique
+ *   sample  Writes randomly picked puzzles (default: 1). Each pick takes
+ *           constant time, irrespective of the size of the bank.
+ *   dump    Writes all puzzles
+ *   import  Grades the puzzles read from the given files (see PuzzleReader.h),
+ *           or one per line from stdin when there are none, and appends them
+ *           to the bank. It is created when it does not yet exist.
+ *
+ *   -n  Number of puzzles to sample
+ *   -s  Seed for the random generator (default: based on time)
+ *   -v  Also write the score and hardest technique of each puzzle
+ *   -y  Treat the imported puzzles as Hyper Sudokus
+ *
+ * Puzzles are written one per line (see PuzzleIO.h).
+ */
+
+#include <random>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "Grader.h"
+#include "Sudoku.h"
+
+#include "PuzzleBank.h"
+#include "PuzzleReader.h"
+#include "PuzzleIO.h"
+
+void usage() {
+  fprintf(
+    stderr,
+    "Usage: bank info <bank>\n"
+    "       bank sample [-n count] [-s seed] [-v] <bank>\n"
+    "       bank dump [-v] <bank>\n"
+    "       bank import [-y] <bank> [file...]\n"
+  );
+  exit(EXIT_FAILURE);
+}
+
+void writeEntry(Sudoku& sudoku, const BankEntry& entry, bool verbose) {
+  char line[puzzleLineLen + 1];
+
+  formatPuzzleLine(sudoku, line);
+  if (verbose) {
+    printf(
+      "%s %d %s%s\n", line, entry.score, techniqueName(entry.hardest),
+      entry.hyper ? " hyper" : ""
+    );
+  } else {
+    printf("%s\n", line);
+  }
+}
+
+int info(PuzzleBank& bank) {
+  Sudoku sudoku;
+  int numHyper = 0;
+  int numHardest[numTechniques] = { 0 };
+  sudoku.init();
+
+  for (uint32_t i = 0; i < bank.count(); i++) {
+    BankEntry entry = bank.read(i, sudoku);
+    numHyper += entry.hyper ? 1 : 0;
+    numHardest[(int)entry.hardest]++;
+  }
+
+  printf(
+    "%u %dx%d puzzles (%u normal, %d hyper), %d bytes each\n",
+    bank.count(), numCols, numRows, bank.count() - numHyper, numHyper, bankRecordSize
+  );
+  for (int i = 0; i < numTechniques; i++) {
+    printf("  %-18s %8d\n", techniqueName((Technique)i), numHardest[i]);
+  }
+
+  return EXIT_SUCCESS;
+}
+
+int sample(PuzzleBank& bank, int numPuzzles, uint32_t seed, bool verbose) {
+  if (bank.count() == 0) {
+    fprintf(stderr, "The bank is empty\n");
+    return EXIT_FAILURE;
+  }
+
+  Sudoku sudoku;
+  std::mt19937 random(seed);
+  std::uniform_int_distribution<uint32_t> pick(0, bank.count() - 1);
+  sudoku.init();
+
+  for (int i = 0; i < numPuzzles; i++) {
+    BankEntry entry = bank.read(pick(random), sudoku);
+    writeEntry(sudoku, entry, verbose);
+  }
+
+  return EXIT_SUCCESS;
+}
+
+int dump(PuzzleBank& bank, bool verbose) {
+  Sudoku sudoku;
+  sudoku.init();
+
+  for (uint32_t i = 0; i < bank.count(); i++) {
+    BankEntry entry = bank.read(i, sudoku);
+    writeEntry(sudoku, entry, verbose);
+  }
+
+  return EXIT_SUCCESS;
+}
+
+bool importPuzzle(Grader& grader, Sudoku& sudoku, PuzzleBankWriter& writer) {
+  int score = grader.grade();
+  if (!writer.append(sudoku, score, grader.hardestTechnique())) {
+    perror("write");
+    return false;
+  }
+  return true;
+}
+
+bool importPuzzles(FILE* in, const char* name, bool hyper, PuzzleBankWriter& writer) {
+  Sudoku sudoku;
+  Grader grader(sudoku);
+  int numImported = 0;
+  sudoku.init();
+
+  while (readPuzzleLine(in, sudoku, hyper)) {
+    if (!importPuzzle(grader, sudoku, writer)) {
+      return false;
+    }
+    numImported++;
+  }
+
+  if (!feof(in)) {
+    fprintf(stderr, "%s: invalid puzzle after %d puzzles\n", name, numImported);
+    return false;
+  }
+  return true;
+}
+
+bool importFile(const char* filename, bool hyper, PuzzleBankWriter& writer) {
+  PuzzleReader reader;
+  if (!reader.open(filename)) {
+    return false;
+  }
+
+  Sudoku sudoku;
+  Grader grader(sudoku);
+  sudoku.init();
+
+  while (reader.next(sudoku, hyper)) {
+    if (!importPuzzle(grader, sudoku, writer)) {
+      return false;
+    }
+  }
+
+  if (reader.failed()) {
+    fprintf(stderr, "%s: invalid puzzle after %d puzzles\n", filename, reader.numRead());
+    return false;
+  }
+  return true;
+}
+
+int import(const char* bankFile, bool hyper, int numFiles, char* files[]) {
+  PuzzleBankWriter writer;
+  if (!writer.open(bankFile)) {
+    return EXIT_FAILURE;
+  }
+  uint32_t numBefore = writer.count();
+
+  bool ok = true;
+  if (numFiles == 0) {
+    ok = importPuzzles(stdin, "stdin", hyper, writer);
+  }
+  for (int i = 0; i < numFiles && ok; i++) {
+    ok = importFile(files[i], hyper, writer);
+  }
+
+  // Also keep the puzzles imported before a failure
+  if (!writer.close()) {
+    perror(bankFile);
+    return EXIT_FAILURE;
+  }
+  fprintf(stderr, "Imported %u puzzles, the bank now holds %u\n",
+    writer.count() - numBefore, writer.count());
+
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int main(int argc, char* argv[]) {
+  if (argc < 2) {
+    usage();
+  }
+  const char* command = argv[1];
+
+  int numPuzzles = 1;
+  uint32_t seed = (uint32_t)time(NULL);
+  bool verbose = false;
+  bool hyper = false;
+
+  // Parse the options that follow the command
+  argc--;
+  argv++;
+  int opt;
+  while ((opt = getopt(argc, argv, "n:s:vy")) != -1) {
+    switch (opt) {
+      case 'n': numPuzzles = atoi(optarg); break;
+      case 's': seed = (uint32_t)strtoul(optarg, NULL, 10); break;
+      case 'v': verbose = true; break;
+      case 'y': hyper = true; break;
+      default: usage();
+    }
+  }
+  if (optind == argc) {
+    usage();
+  }
+  const char* bankFile = argv[optind++];
+
+  if (strcmp(command, "import") == 0) {
+    if (hyper && !hyperSupported) {
+      fprintf(stderr, "Hyper Sudokus are only supported for 9x9 puzzles\n");
+      return EXIT_FAILURE;
+    }
+    return import(bankFile, hyper, argc - optind, argv + optind);
+  }
+
+  if (optind != argc) {
+    usage();
+  }
+  PuzzleBank bank;
+  if (!bank.open(bankFile)) {
+    return EXIT_FAILURE;
+  }
+
+  if (strcmp(command, "info") == 0) {
+    return info(bank);
+  }
+  if (strcmp(command, "sample") == 0) {
+    return sample(bank, numPuzzles, seed, verbose);
+  }
+  if (strcmp(command, "dump") == 0) {
+    return dump(bank, verbose);
+  }
+  usage();
+  return EXIT_FAILURE;
+}
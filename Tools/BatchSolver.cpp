@@ -0,0 +1,114 @@
+/*
+ * Sudoku, a Gamebuino game
+ *
+ * Copyright 2018, Erwin Bonsma
+ */
+
+#include "BatchSolver.h"
+
+#include <string.h>
+
+#include "Utils.h"
+
+BatchSolver::BatchSolver(int numLanes)
+  : _nodesPerTurn(16), _numNodes(0), _numBacktracks(0) {
+
+  for (int i = 0; i < maxBatchLanes; i++) {
+    _lanes[i].sudoku.init();
+  }
+  setNumLanes(numLanes);
+}
+
+void BatchSolver::setNumLanes(int numLanes) {
+  assertTrue(numLanes >= 1 && numLanes <= maxBatchLanes);
+  _numLanes = numLanes;
+}
+
+bool BatchSolver::startNext(Lane& lane) {
+  while (_nextPuzzle < _numPuzzles) {
+    int index = _nextPuzzle++;
+    const uint8_t* puzzle = _puzzles + (size_t)index * packedPuzzleSize;
+
+    if (lane.sudoku.reset(_hyper, puzzle)) {
+      lane.puzzleIndex = index;
+      lane.solver.setSolutionBuffer(lane.solution, 1);
+      if (_operation == BatchOperation::Solve) {
+        lane.solver.startSolve();
+      } else {
+        lane.solver.startCountSolutions();
+      }
+      return true;
+    }
+
+    // Violates a constraint
+    _counts[index] = (uint8_t)SolutionCount::None;
+    if (_solutions != NULL) {
+      memset(_solutions + (size_t)index * packedPuzzleSize, 0, packedPuzzleSize);
+    }
+  }
+
+  lane.puzzleIndex = -1;
+  return false;
+}
+
+void BatchSolver::finish(Lane& lane) {
+  int index = lane.puzzleIndex;
+  int numSolutions = lane.solver.numSolutionsFound();
+
+  _counts[index] = (uint8_t)numSolutions;
+  if (_solutions != NULL) {
+    uint8_t* solution = _solutions + (size_t)index * packedPuzzleSize;
+    for (int i = 0; i < numCells; i++) {
+      solution[i] = (numSolutions > 0) ? (uint8_t)bitToValue(lane.solution[i]) : 0;
+    }
+  }
+
+  _numNodes += lane.solver.numNodes();
+  _numBacktracks += lane.solver.numBacktracks();
+}
+
+void BatchSolver::solve(
+  const uint8_t* puzzles, int numPuzzles, bool hyperConstraints,
+  BatchOperation operation, uint8_t* counts, uint8_t* solutions
+) {
+  _puzzles = puzzles;
+  _numPuzzles = numPuzzles;
+  _nextPuzzle = 0;
+  _hyper = hyperConstraints;
+  _operation = operation;
+  _counts = counts;
+  _solutions = solutions;
+  _numNodes = 0;
+  _numBacktracks = 0;
+
+  if (_numLanes == 1) {
+    // Nothing to interleave, so each search runs without interruption
+    Lane& lane = _lanes[0];
+    while (startNext(lane)) {
+      lane.solver.step(0);
+      finish(lane);
+    }
+    return;
+  }
+
+  int numActive = 0;
+  for (int i = 0; i < _numLanes; i++) {
+    if (startNext(_lanes[i])) {
+      numActive++;
+    }
+  }
+
+  while (numActive > 0) {
+    for (int i = 0; i < _numLanes; i++) {
+      Lane& lane = _lanes[i];
+      if (lane.puzzleIndex < 0 || !lane.solver.stepNodes(_nodesPerTurn)) {
+        continue;
+      }
+
+      finish(lane);
+      if (!startNext(lane)) {
+        numActive--;
+      }
+    }
+  }
+}
@@ -0,0 +1,101 @@
+/*
+ * Sudoku, a Gamebuino game
+ *
+ * Copyright 2018, Erwin Bonsma
+ */
+
+#ifndef __BATCH_SOLVER_INCLUDED
+#define __BATCH_SOLVER_INCLUDED
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "Solver.h"
+#include "Sudoku.h"
+
+// The size of a packed puzzle, one byte per cell (see Sudoku::reset)
+const int packedPuzzleSize = numCells;
+
+const int maxBatchLanes = 8;
+
+enum class BatchOperation : int {
+  // Finds a solution, as Solver::solve()
+  Solve,
+  // Counts the solutions up to two, as Solver::countSolutions()
+  CountSolutions
+};
+
+/* Solves many puzzles per call.
+ *
+ * The puzzles are given as a contiguous array of packed puzzles. The solution
+ * counts, and optionally the first solution of each puzzle, are written to
+ * output arrays.
+ *
+ * Each lane has its own puzzle and solver, which are set up once and then
+ * reused for all puzzles the lane handles. Puzzles are loaded in bulk instead
+ * of value by value. With multiple lanes, their searches are interleaved, each
+ * lane trying a fixed number of nodes per turn using the solver's resumable
+ * search.
+ */
+class BatchSolver {
+  struct Lane {
+    Sudoku sudoku;
+    Solver solver;
+
+    // The puzzle the lane is solving, or -1 when it is idle
+    int puzzleIndex;
+
+    // The first solution, as a bit value per cell
+    int solution[numCells];
+
+    Lane() : sudoku(), solver(sudoku), puzzleIndex(-1) {}
+  };
+
+  Lane _lanes[maxBatchLanes];
+  int _numLanes;
+
+  // The nodes that each lane tries per turn
+  int _nodesPerTurn;
+
+  // Search statistics of the last batch
+  long _numNodes;
+  long _numBacktracks;
+
+  // The batch that is being solved
+  const uint8_t* _puzzles;
+  int _numPuzzles;
+  int _nextPuzzle;
+  bool _hyper;
+  BatchOperation _operation;
+  uint8_t* _counts;
+  uint8_t* _solutions;
+
+  // Makes the lane start on the next puzzle. Returns false when there is none.
+  bool startNext(Lane& lane);
+
+  void finish(Lane& lane);
+
+public:
+  BatchSolver(int numLanes = 1);
+
+  void setNumLanes(int numLanes);
+  int numLanes() { return _numLanes; }
+
+  void setNodesPerTurn(int numNodes) { _nodesPerTurn = numNodes; }
+
+  /* Solves the given puzzles. The solution count of each (a SolutionCount) is
+   * written to "counts", so when solving it is None or One. Puzzles that
+   * violate a constraint have no solutions. When "solutions" is not NULL, the
+   * first solution of each puzzle is written there, packed, with all values
+   * zero when there is none.
+   */
+  void solve(
+    const uint8_t* puzzles, int numPuzzles, bool hyperConstraints,
+    BatchOperation operation, uint8_t* counts, uint8_t* solutions = NULL
+  );
+
+  long numNodes() { return _numNodes; }
+  long numBacktracks() { return _numBacktracks; }
+};
+
+#endif
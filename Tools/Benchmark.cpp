@@ -0,0 +1,405 @@
+/*
+ * Sudoku, a Gamebuino game
+ *
+ * Copyright 2018, Erwin Bonsma
+ */
+
+/* Benchmarks the solver engines.
+ *
+ * It reads one or more corpora of puzzles (see PuzzleReader.h for the formats,
+ * and the Corpora directory for some standard ones). For each corpus it runs
+ * solve(), isSolvable() and countSolutions() on every puzzle using each
+ * engine. It reports the per-puzzle latency percentiles, the total time and
+ * throughput, and the total number of search nodes and backtracks, and checks
+ * that all engines agree.
+ *
+ * When the engine is built with SOLVER_STATS, a second table follows for the
+ * engines based on Solver. It gives the totals of the search statistics (see
+ * SolverStats in Solver.h) over all puzzles, and the maximum depth and number
+ * of cells set by propagation.
+ *
+ * The batch engine solves all puzzles of the corpus in one call (see
+ * BatchSolver.h). As puzzles are not timed individually, it has no latency
+ * percentiles. It handles isSolvable() as solve(), as it leaves the puzzles
+ * unmodified either way.
+ *
+ * Usage: benchmark [-y] [-r repeats] [-e engine] [-p stages] [-l lanes] file...
+ *   -y  Treat the puzzles as Hyper Sudokus
+ *   -r  Number of times to run each operation per puzzle (default: 1)
+ *   -e  Only run the given engine ("solver", "solver-snap", "solver-mrv",
+ *       "solver-prop", "bitboard", "dlx" or "batch")
+ *   -p  Propagation stages used by solver-prop, as a mask of the *Stage
+ *       constants in Solver.h (default: all)
+ *   -l  Number of interleaved lanes used by the batch engine (default: 1)
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <vector>
+
+#include "Sudoku.h"
+#include "Solver.h"
+
+#include "BatchSolver.h"
+#include "BitBoardSolver.h"
+#include "DlxSolver.h"
+#include "PuzzleIO.h"
+#include "PuzzleReader.h"
+
+enum class Operation : int {
+  Solve,
+  IsSolvable,
+  CountSolutions
+};
+const int numOperations = 3;
+const char* operationNames[numOperations] = {
+  "solve", "isSolvable", "countSolutions"
+};
+
+const int numEngines = 7;
+const char* engineNames[numEngines] = {
+  "solver", "solver-snap", "solver-mrv", "solver-prop", "bitboard", "dlx", "batch"
+};
+
+// Solver that backtracks by restoring snapshots instead of undoing changes
+class SnapshotSolver : public Solver {
+  SudokuState _snapshotBuffer[numCells];
+
+public:
+  SnapshotSolver(Sudoku& s) : Solver(s) {
+    setSnapshotBuffer(_snapshotBuffer, numCells);
+  }
+};
+
+// Solver that branches on the cell with the fewest possible values
+class MinRemainingSolver : public Solver {
+public:
+  MinRemainingSolver(Sudoku& s) : Solver(s) {
+    setBranchOrder(BranchOrder::MinRemaining);
+  }
+};
+
+int selectedStages = allPropagationStages;
+int numBatchLanes = 1;
+
+// Solver with optional propagation stages enabled
+class PropagatingSolver : public Solver {
+public:
+  PropagatingSolver(Sudoku& s) : Solver(s) {
+    setPropagationStages(selectedStages);
+  }
+};
+
+struct OperationResult {
+  // Average latency per puzzle, in microseconds. Empty when the puzzles were
+  // not timed individually.
+  std::vector<double> latencies;
+
+  // Average time for all puzzles, in microseconds
+  double totalMicros;
+
+  // Outcome per puzzle, used to cross-check the engines
+  std::vector<int> outcomes;
+
+  long totalNodes;
+  long totalBacktracks;
+
+#ifdef SOLVER_STATS
+  bool hasStats;
+  SolverStats stats;
+#endif
+};
+
+#ifdef SOLVER_STATS
+// Only the engines based on Solver collect statistics
+void collectStats(Solver& solver, OperationResult& result) {
+  result.hasStats = true;
+  result.stats = solver.stats();
+}
+void collectStats(BitBoardSolver& solver, OperationResult& result) {
+  result.hasStats = false;
+}
+void collectStats(DlxSolver& solver, OperationResult& result) {
+  result.hasStats = false;
+}
+#endif
+
+template <typename T>
+int runOperation(T& solver, Operation op) {
+  switch (op) {
+    case Operation::Solve: return solver.solve();
+    case Operation::IsSolvable: return solver.isSolvable();
+    case Operation::CountSolutions: return (int)solver.countSolutions();
+  }
+  return -1;
+}
+
+template <typename T>
+void benchmark(
+  const std::vector<uint8_t>& puzzles, bool hyper, int repeats, Operation op,
+  OperationResult& result
+) {
+  int numPuzzles = (int)puzzles.size() / packedPuzzleSize;
+  Sudoku sudoku;
+  T solver(sudoku);
+  sudoku.init();
+
+  result.latencies.clear();
+  result.outcomes.clear();
+  result.totalMicros = 0;
+  result.totalNodes = 0;
+  result.totalBacktracks = 0;
+
+  for (int p = 0; p < numPuzzles; p++) {
+    std::chrono::duration<double, std::micro> total(0);
+    int outcome = 0;
+
+    for (int i = 0; i < repeats; i++) {
+      // Always reset, as solve() fills in the puzzle
+      sudoku.reset(hyper, &puzzles[p * packedPuzzleSize]);
+
+      auto start = std::chrono::steady_clock::now();
+      outcome = runOperation(solver, op);
+      total += std::chrono::steady_clock::now() - start;
+
+      result.totalNodes += solver.numNodes();
+      result.totalBacktracks += solver.numBacktracks();
+    }
+
+    result.latencies.push_back(total.count() / repeats);
+    result.totalMicros += total.count() / repeats;
+    result.outcomes.push_back(outcome);
+  }
+
+#ifdef SOLVER_STATS
+  collectStats(solver, result);
+#endif
+}
+
+void benchmarkBatch(
+  const std::vector<uint8_t>& puzzles, bool hyper, int repeats, Operation op,
+  OperationResult& result
+) {
+  BatchSolver solver(numBatchLanes);
+  int numPuzzles = (int)puzzles.size() / packedPuzzleSize;
+  std::vector<uint8_t> counts(numPuzzles);
+
+  BatchOperation batchOp = (
+    (op == Operation::CountSolutions)
+    ? BatchOperation::CountSolutions
+    : BatchOperation::Solve
+  );
+
+  result.totalNodes = 0;
+  result.totalBacktracks = 0;
+#ifdef SOLVER_STATS
+  result.hasStats = false;
+#endif
+
+  auto start = std::chrono::steady_clock::now();
+  for (int i = 0; i < repeats; i++) {
+    solver.solve(puzzles.data(), numPuzzles, hyper, batchOp, counts.data());
+    result.totalNodes += solver.numNodes();
+    result.totalBacktracks += solver.numBacktracks();
+  }
+  std::chrono::duration<double, std::micro> total = std::chrono::steady_clock::now() - start;
+
+  result.latencies.clear();
+  result.totalMicros = total.count() / repeats;
+  result.outcomes.assign(counts.begin(), counts.end());
+}
+
+// Nearest-rank percentile of the sorted values
+double percentile(const std::vector<double>& sorted, int p) {
+  if (sorted.empty()) {
+    return 0;
+  }
+  size_t rank = (sorted.size() * p + 99) / 100;
+  return sorted[std::max(rank, (size_t)1) - 1];
+}
+
+void report(const char* engine, Operation op, const OperationResult& result) {
+  std::vector<double> sorted = result.latencies;
+  std::sort(sorted.begin(), sorted.end());
+
+  printf("%-11s %-15s", engine, operationNames[(int)op]);
+  if (sorted.empty()) {
+    printf(" %9s %9s %9s %9s", "-", "-", "-", "-");
+  } else {
+    printf(
+      " %9.1f %9.1f %9.1f %9.1f",
+      percentile(sorted, 50), percentile(sorted, 90), percentile(sorted, 99), sorted.back()
+    );
+  }
+
+  int numPuzzles = (int)result.outcomes.size();
+  printf(
+    " %10.2f %10.0f %11ld %11ld\n",
+    result.totalMicros / 1000,
+    result.totalMicros > 0 ? numPuzzles * 1e6 / result.totalMicros : 0.0,
+    result.totalNodes, result.totalBacktracks
+  );
+}
+
+#ifdef SOLVER_STATS
+void reportStats(OperationResult results[numOperations][numEngines], int engineMask) {
+  printf(
+    "%-11s %-15s %11s %11s %11s %11s %11s %8s %10s\n",
+    "Engine", "Operation", "nodes", "naked", "hidden", "backtracks", "cleared",
+    "maxDepth", "maxAutoSet"
+  );
+  for (int engine = 0; engine < numEngines; engine++) {
+    for (int op = 0; op < numOperations; op++) {
+      OperationResult& result = results[op][engine];
+      if ((engineMask & (1 << engine)) == 0 || !result.hasStats) {
+        continue;
+      }
+      const SolverStats& stats = result.stats;
+      printf(
+        "%-11s %-15s %11ld %11ld %11ld %11ld %11ld %8d %10d\n",
+        engineNames[engine], operationNames[op], stats.numNodes,
+        stats.numNakedSingles, stats.numHiddenSingles, stats.numBacktracks,
+        stats.numAutoCleared, stats.maxDepth, stats.maxAutoSet
+      );
+    }
+  }
+}
+#endif
+
+// Loads the puzzles packed, one after another (see Sudoku::reset)
+bool loadPuzzles(const char* filename, bool hyper, std::vector<uint8_t>& puzzles) {
+  PuzzleReader reader;
+  if (!reader.open(filename)) {
+    return false;
+  }
+
+  Sudoku sudoku;
+  sudoku.init();
+  while (reader.next(sudoku, hyper)) {
+    for (int i = 0; i < numCells; i++) {
+      puzzles.push_back((uint8_t)bitToValue(sudoku.cellAt(i).getBitValue()));
+    }
+  }
+  if (reader.failed()) {
+    fprintf(stderr, "%s: invalid puzzle after %d puzzles\n", filename, reader.numRead());
+    return false;
+  }
+
+  return true;
+}
+
+bool benchmarkCorpus(const char* filename, bool hyper, int repeats, int engineMask) {
+  std::vector<uint8_t> puzzles;
+  if (!loadPuzzles(filename, hyper, puzzles)) {
+    return false;
+  }
+
+  printf(
+    "== %s: %d %s %dx%d puzzles\n", filename, (int)puzzles.size() / packedPuzzleSize,
+    hyper ? "hyper" : "normal", numCols, numRows
+  );
+  printf(
+    "%-11s %-15s %9s %9s %9s %9s %10s %10s %11s %11s\n",
+    "Engine", "Operation", "p50(us)", "p90(us)", "p99(us)", "max(us)", "total(ms)",
+    "puzzles/s", "nodes", "backtracks"
+  );
+
+  OperationResult allResults[numOperations][numEngines];
+  for (int i = 0; i < numOperations; i++) {
+    Operation op = (Operation)i;
+    OperationResult* results = allResults[i];
+    int reference = -1;
+
+    for (int engine = 0; engine < numEngines; engine++) {
+      if ((engineMask & (1 << engine)) == 0) {
+        continue;
+      }
+
+      switch (engine) {
+        case 0: benchmark<Solver>(puzzles, hyper, repeats, op, results[engine]); break;
+        case 1: benchmark<SnapshotSolver>(puzzles, hyper, repeats, op, results[engine]); break;
+        case 2: benchmark<MinRemainingSolver>(puzzles, hyper, repeats, op, results[engine]); break;
+        case 3: benchmark<PropagatingSolver>(puzzles, hyper, repeats, op, results[engine]); break;
+        case 4: benchmark<BitBoardSolver>(puzzles, hyper, repeats, op, results[engine]); break;
+        case 5: benchmark<DlxSolver>(puzzles, hyper, repeats, op, results[engine]); break;
+        case 6: benchmarkBatch(puzzles, hyper, repeats, op, results[engine]); break;
+      }
+      report(engineNames[engine], op, results[engine]);
+
+      if (reference < 0) {
+        reference = engine;
+      } else if (results[engine].outcomes != results[reference].outcomes) {
+        fprintf(
+          stderr, "Engines %s and %s disagree on %s\n",
+          engineNames[reference], engineNames[engine], operationNames[i]
+        );
+        return false;
+      }
+    }
+  }
+  printf("\n");
+
+#ifdef SOLVER_STATS
+  reportStats(allResults, engineMask);
+  printf("\n");
+#endif
+
+  return true;
+}
+
+void usage(const char* name) {
+  fprintf(
+    stderr, "Usage: %s [-y] [-r repeats] [-e engine] [-p stages] [-l lanes] file...\n",
+    name
+  );
+  exit(EXIT_FAILURE);
+}
+
+int main(int argc, char* argv[]) {
+  bool hyper = false;
+  int repeats = 1;
+  int engineMask = (1 << numEngines) - 1;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "yr:e:p:l:")) != -1) {
+    switch (opt) {
+      case 'y': hyper = true; break;
+      case 'r': repeats = atoi(optarg); break;
+      case 'p': selectedStages = atoi(optarg) & allPropagationStages; break;
+      case 'l': numBatchLanes = atoi(optarg); break;
+      case 'e':
+        engineMask = 0;
+        for (int i = 0; i < numEngines; i++) {
+          if (strcmp(optarg, engineNames[i]) == 0) {
+            engineMask = 1 << i;
+          }
+        }
+        if (engineMask == 0) {
+          usage(argv[0]);
+        }
+        break;
+      default: usage(argv[0]);
+    }
+  }
+  if (optind == argc || repeats < 1 || numBatchLanes < 1 || numBatchLanes > maxBatchLanes) {
+    usage(argv[0]);
+  }
+  if (hyper && !hyperSupported) {
+    fprintf(stderr, "Hyper Sudokus are only supported for 9x9 puzzles\n");
+    return EXIT_FAILURE;
+  }
+
+  BitBoardSolver::initTables();
+
+  for (int i = optind; i < argc; i++) {
+    if (!benchmarkCorpus(argv[i], hyper, repeats, engineMask)) {
+      return EXIT_FAILURE;
+    }
+  }
+
+  return EXIT_SUCCESS;
+}
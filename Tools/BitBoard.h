@@ -0,0 +1,85 @@
+/*
+ * Sudoku, a Gamebuino game
+ *
+ * Copyright 2018, Erwin Bonsma
+ */
+
+#ifndef __BITBOARD_INCLUDED
+#define __BITBOARD_INCLUDED
+
+#include <stdint.h>
+
+#include "Constants.h"
+
+const int numBoardWords = (numCells + 63) / 64;
+
+/* A set of cells, with one bit per cell.
+ *
+ * All operations work on whole words, so for a 9x9 puzzle each is a pair of
+ * 64-bit operations, which compilers typically map onto a single 128-bit SIMD
+ * instruction.
+ */
+struct BitBoard {
+  uint64_t w[numBoardWords];
+
+  void clearAll() {
+    for (int i = 0; i < numBoardWords; i++) w[i] = 0;
+  }
+
+  void set(int cellIndex) { w[cellIndex >> 6] |= (uint64_t)1 << (cellIndex & 63); }
+  void clear(int cellIndex) { w[cellIndex >> 6] &= ~((uint64_t)1 << (cellIndex & 63)); }
+  bool contains(int cellIndex) const {
+    return ((w[cellIndex >> 6] >> (cellIndex & 63)) & 1) != 0;
+  }
+
+  bool isEmpty() const {
+    uint64_t m = 0;
+    for (int i = 0; i < numBoardWords; i++) m |= w[i];
+    return m == 0;
+  }
+
+  int count() const {
+    int n = 0;
+    for (int i = 0; i < numBoardWords; i++) n += __builtin_popcountll(w[i]);
+    return n;
+  }
+
+  // Index of the lowest cell in the set. The set should not be empty.
+  int first() const {
+    int i = 0;
+    while (w[i] == 0) i++;
+    return (i << 6) + __builtin_ctzll(w[i]);
+  }
+
+  BitBoard operator&(const BitBoard& o) const {
+    BitBoard r;
+    for (int i = 0; i < numBoardWords; i++) r.w[i] = w[i] & o.w[i];
+    return r;
+  }
+  BitBoard operator|(const BitBoard& o) const {
+    BitBoard r;
+    for (int i = 0; i < numBoardWords; i++) r.w[i] = w[i] | o.w[i];
+    return r;
+  }
+  // Returns the cells in this set that are not in the other
+  BitBoard without(const BitBoard& o) const {
+    BitBoard r;
+    for (int i = 0; i < numBoardWords; i++) r.w[i] = w[i] & ~o.w[i];
+    return r;
+  }
+
+  BitBoard& operator&=(const BitBoard& o) {
+    for (int i = 0; i < numBoardWords; i++) w[i] &= o.w[i];
+    return *this;
+  }
+  BitBoard& operator|=(const BitBoard& o) {
+    for (int i = 0; i < numBoardWords; i++) w[i] |= o.w[i];
+    return *this;
+  }
+  BitBoard& removeAll(const BitBoard& o) {
+    for (int i = 0; i < numBoardWords; i++) w[i] &= ~o.w[i];
+    return *this;
+  }
+};
+
+#endif
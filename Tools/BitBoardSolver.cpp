@@ -0,0 +1,215 @@
+/*
+ * Sudoku, a Gamebuino game
+ *
+ * Copyright 2018, Erwin Bonsma
+ */
+
+#include "BitBoardSolver.h"
+
+#include "Globals.h"
+#include "Utils.h"
+
+// The cells of each constraint group
+BitBoard groupCells[numConstraintGroups];
+
+// The cells that each cell constrains, without and with hyper constraints
+BitBoard basicPeers[numCells];
+BitBoard hyperPeers[numCells];
+
+void BitBoardSolver::initTables() {
+  for (int i = 0; i < numConstraintGroups; i++) {
+    groupCells[i].clearAll();
+    for (int j = 0; j < constraintGroupSize; j++) {
+      groupCells[i].set(constraintCells[i][j]);
+    }
+  }
+
+  for (int c = 0; c < numCells; c++) {
+    basicPeers[c].clearAll();
+    hyperPeers[c].clearAll();
+  }
+  for (int i = 0; i < numConstraintGroups; i++) {
+    for (int j = 0; j < constraintGroupSize; j++) {
+      int c = constraintCells[i][j];
+      if (i < numBasicConstraintGroups) {
+        basicPeers[c] |= groupCells[i];
+      }
+      hyperPeers[c] |= groupCells[i];
+    }
+  }
+  for (int c = 0; c < numCells; c++) {
+    basicPeers[c].clear(c);
+    hyperPeers[c].clear(c);
+  }
+}
+
+BitBoardSolver::BitBoardSolver(Sudoku& s)
+  : _s(s), _numNodes(0), _numBacktracks(0) {}
+
+void BitBoardSolver::place(
+  State& state, const BitBoard* peers, int cellIndex, int value
+) {
+  for (int v = 0; v < numValues; v++) {
+    state.candidates[v].clear(cellIndex);
+  }
+  state.candidates[value].removeAll(peers[cellIndex]);
+  state.placed[value].set(cellIndex);
+  state.unset.clear(cellIndex);
+}
+
+bool BitBoardSolver::propagate(State& state) {
+  bool progress = true;
+
+  while (progress) {
+    progress = false;
+
+    // Naked singles. Determine for all cells at once which have at least one,
+    // and which at least two candidates.
+    BitBoard once, twice;
+    once.clearAll();
+    twice.clearAll();
+    for (int v = 0; v < numValues; v++) {
+      twice |= once & state.candidates[v];
+      once |= state.candidates[v];
+    }
+    if (!state.unset.without(once).isEmpty()) {
+      return true; // Stuck: a cell without candidates
+    }
+
+    BitBoard singles = once.without(twice);
+    while (!singles.isEmpty()) {
+      int c = singles.first();
+      singles.clear(c);
+
+      int v = 0;
+      while (v < numValues && !state.candidates[v].contains(c)) {
+        v++;
+      }
+      if (v == numValues) {
+        return true; // Stuck: lost its last candidate due to an earlier single
+      }
+      place(state, _peers, c, v);
+      progress = true;
+    }
+    if (progress) {
+      continue;
+    }
+
+    // Hidden singles
+    for (int g = _numActiveConstraints; --g >= 0; ) {
+      const BitBoard& group = groupCells[g];
+      for (int v = numValues; --v >= 0; ) {
+        if (!(state.placed[v] & group).isEmpty()) {
+          continue;
+        }
+        BitBoard positions = state.candidates[v] & group;
+        int n = positions.count();
+        if (n == 0) {
+          return true; // Stuck: value cannot be placed in group
+        }
+        if (n == 1) {
+          place(state, _peers, positions.first(), v);
+          progress = true;
+        }
+      }
+    }
+  }
+
+  return false;
+}
+
+bool BitBoardSolver::solve(State& state) {
+  if (propagate(state)) {
+    return false;
+  }
+
+  if (state.unset.isEmpty()) {
+    if (_numSolutionsFound++ == 0) {
+      _solution = state;
+    }
+    return (_numSolutionsFound == _numSolutionsToFind);
+  }
+
+  int c = state.unset.first();
+  for (int v = 0; v < numValues; v++) {
+    if (state.candidates[v].contains(c)) {
+      State branch = state;
+      place(branch, _peers, c, v);
+      _numNodes++;
+      if (solve(branch)) {
+        return true;
+      }
+      _numBacktracks++;
+    }
+  }
+
+  return false;
+}
+
+int BitBoardSolver::findSolutions(int numSolutionsToFind) {
+  _numSolutionsToFind = numSolutionsToFind;
+  _numSolutionsFound = 0;
+  _numNodes = 0;
+  _numBacktracks = 0;
+
+  bool hyper = _s.hyperConstraintsEnabled();
+  _numActiveConstraints = hyper ? numConstraintGroups : numBasicConstraintGroups;
+  _peers = hyper ? hyperPeers : basicPeers;
+
+  State state;
+  for (int v = 0; v < numValues; v++) {
+    state.placed[v].clearAll();
+    state.candidates[v].clearAll();
+  }
+  state.unset.clearAll();
+  for (int c = 0; c < numCells; c++) {
+    state.unset.set(c);
+  }
+  for (int v = 0; v < numValues; v++) {
+    state.candidates[v] = state.unset;
+  }
+
+  for (int c = 0; c < numCells; c++) {
+    int bit = _s.cellAt(c).getBitValue();
+    if (bit != 0) {
+      int v = bitToValue(bit) - 1;
+      if (!state.candidates[v].contains(c)) {
+        // The value clashes with another one. This can happen while editing
+        // because the implicit hyper-boxes are not enforced then.
+        return 0;
+      }
+      place(state, _peers, c, v);
+    }
+  }
+
+  solve(state);
+
+  return _numSolutionsFound;
+}
+
+bool BitBoardSolver::solve() {
+  if (findSolutions(1) != 1) {
+    return false;
+  }
+
+  for (int c = 0; c < numCells; c++) {
+    SudokuCell& cell = _s.cellAt(c);
+    if (!cell.isSet()) {
+      for (int v = 0; v < numValues; v++) {
+        if (_solution.placed[v].contains(c)) {
+          _s.setBitValue(cell, valueToBit(v + 1));
+        }
+      }
+    }
+  }
+
+  return true;
+}
+
+bool BitBoardSolver::isSolvable() {
+  return (findSolutions(1) == 1);
+}
+
+SolutionCount BitBoardSolver::countSolutions() {
+  return (SolutionCount)findSolutions(2);
+}
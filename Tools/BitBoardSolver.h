@@ -0,0 +1,81 @@
+/*
+ * Sudoku, a Gamebuino game
+ *
+ * Copyright 2018, Erwin Bonsma
+ */
+
+#ifndef __BITBOARD_SOLVER_INCLUDED
+#define __BITBOARD_SOLVER_INCLUDED
+
+#include "Solver.h"
+#include "Sudoku.h"
+
+#include "BitBoard.h"
+
+/* Solver that uses bitboards instead of the per-group masks of Sudoku.
+ *
+ * For each value it keeps the set of cells where it can still be placed. This
+ * way, where a value can go in a group is a single AND of two bitboards, and
+ * naked singles and dead ends can be found for all cells at once by combining
+ * the bitboards of all values.
+ *
+ * It has the same public interface as Solver. It only reads the puzzle when a
+ * solve starts and searches on its own copy, which is copied on each branch.
+ * The puzzle is only modified by solve(), which fills in the solution found.
+ */
+class BitBoardSolver {
+  struct State {
+    // For each value, the cells where it can still be placed
+    BitBoard candidates[numValues];
+
+    // For each value, the cells where it has been placed
+    BitBoard placed[numValues];
+
+    BitBoard unset;
+  };
+
+  // The puzzle to solve
+  Sudoku& _s;
+
+  int _numActiveConstraints;
+
+  // The cells that each cell constrains, given the active constraints
+  const BitBoard* _peers;
+
+  int _numSolutionsToFind;
+  int _numSolutionsFound;
+
+  // The first solution that was found
+  State _solution;
+
+  // Search statistics of the last solve (see Solver)
+  int _numNodes;
+  int _numBacktracks;
+
+  static void place(State& state, const BitBoard* peers, int cellIndex, int value);
+
+  // Returns true when stuck
+  bool propagate(State& state);
+
+  // Returns "true" if the termination criterion has been reached.
+  bool solve(State& state);
+
+  int findSolutions(int numSolutionsToFind);
+
+public:
+  // Should be called once, before any solver is used
+  static void initTables();
+
+  BitBoardSolver(Sudoku& s);
+
+  Sudoku& sudoku() { return _s; }
+
+  bool solve();
+  bool isSolvable();
+  SolutionCount countSolutions();
+
+  int numNodes() { return _numNodes; }
+  int numBacktracks() { return _numBacktracks; }
+};
+
+#endif
@@ -0,0 +1,231 @@
+/*
+ * Sudoku, a Gamebuino game
+ *
+ * Copyright 2018, Erwin Bonsma
+ */
+
+#include "DlxSolver.h"
+
+#include "Globals.h"
+#include "Utils.h"
+
+DlxSolver::DlxSolver(Sudoku& s)
+  : _s(s), _built(false), _builtForHyper(false), _numNodes(0), _numBacktracks(0) {}
+
+void DlxSolver::build(bool hyper) {
+  int numGroups = hyper ? numConstraintGroups : numBasicConstraintGroups;
+  int numColumns = numCells + numGroups * numValues;
+
+  // The root and column headers form a circular list
+  for (int col = 0; col <= numColumns; col++) {
+    _left[col] = (col == 0) ? numColumns : col - 1;
+    _right[col] = (col == numColumns) ? 0 : col + 1;
+    _up[col] = col;
+    _down[col] = col;
+    _column[col] = col;
+    _size[col] = 0;
+  }
+
+  // The active groups of each cell
+  int cellGroups[numCells][maxConstraintsPerCell];
+  int numCellGroups[numCells];
+  for (int i = 0; i < numCells; i++) {
+    numCellGroups[i] = 0;
+  }
+  for (int g = 0; g < numGroups; g++) {
+    for (int j = 0; j < constraintGroupSize; j++) {
+      int cellIndex = constraintCells[g][j];
+      cellGroups[cellIndex][numCellGroups[cellIndex]++] = g;
+    }
+  }
+
+  int node = numColumns + 1;
+  for (int r = 0; r < numMatrixRows; r++) {
+    int cellIndex = r / numValues;
+    int value = r % numValues;
+
+    int columns[1 + maxConstraintsPerCell];
+    int numRowColumns = 0;
+    columns[numRowColumns++] = 1 + cellIndex;
+    for (int i = 0; i < numCellGroups[cellIndex]; i++) {
+      columns[numRowColumns++] = 1 + numCells + cellGroups[cellIndex][i] * numValues + value;
+    }
+
+    _rowNode[r] = node;
+    for (int i = 0; i < numRowColumns; i++) {
+      int col = columns[i];
+
+      _left[node] = (i == 0) ? node + numRowColumns - 1 : node - 1;
+      _right[node] = (i == numRowColumns - 1) ? node - i : node + 1;
+
+      // Append at the bottom of the column
+      _up[node] = _up[col];
+      _down[node] = col;
+      _down[_up[col]] = node;
+      _up[col] = node;
+
+      _column[node] = col;
+      _row[node] = r;
+      _size[col]++;
+      node++;
+    }
+  }
+  assertTrue(node <= maxNodes);
+
+  _built = true;
+  _builtForHyper = hyper;
+}
+
+void DlxSolver::cover(int col) {
+  _right[_left[col]] = _right[col];
+  _left[_right[col]] = _left[col];
+
+  for (int i = _down[col]; i != col; i = _down[i]) {
+    for (int j = _right[i]; j != i; j = _right[j]) {
+      _down[_up[j]] = _down[j];
+      _up[_down[j]] = _up[j];
+      _size[_column[j]]--;
+    }
+  }
+}
+
+void DlxSolver::uncover(int col) {
+  for (int i = _up[col]; i != col; i = _up[i]) {
+    for (int j = _left[i]; j != i; j = _left[j]) {
+      _size[_column[j]]++;
+      _down[_up[j]] = j;
+      _up[_down[j]] = j;
+    }
+  }
+
+  _right[_left[col]] = col;
+  _left[_right[col]] = col;
+}
+
+void DlxSolver::coverRow(int node) {
+  for (int j = _right[node]; j != node; j = _right[j]) {
+    cover(_column[j]);
+  }
+}
+
+void DlxSolver::uncoverRow(int node) {
+  for (int j = _left[node]; j != node; j = _left[j]) {
+    uncover(_column[j]);
+  }
+}
+
+bool DlxSolver::search(int depth) {
+  if (_right[0] == 0) {
+    if (_numSolutionsFound++ == 0) {
+      for (int i = 0; i < depth; i++) {
+        _solutionRows[i] = _selectedRows[i];
+      }
+      _solutionLen = depth;
+    }
+    return (_numSolutionsFound == _numSolutionsToFind);
+  }
+
+  // Select the column with the fewest rows
+  int col = _right[0];
+  for (int c = _right[col]; c != 0; c = _right[c]) {
+    if (_size[c] < _size[col]) {
+      col = c;
+    }
+  }
+  if (_size[col] == 0) {
+    return false;
+  }
+
+  cover(col);
+  bool terminate = false;
+  for (int r = _down[col]; r != col && !terminate; r = _down[r]) {
+    _selectedRows[depth] = _row[r];
+    coverRow(r);
+    _numNodes++;
+
+    terminate = search(depth + 1);
+
+    uncoverRow(r);
+    if (!terminate) {
+      _numBacktracks++;
+    }
+  }
+  uncover(col);
+
+  return terminate;
+}
+
+int DlxSolver::findSolutions(int numSolutionsToFind) {
+  _numSolutionsToFind = numSolutionsToFind;
+  _numSolutionsFound = 0;
+  _numNodes = 0;
+  _numBacktracks = 0;
+
+  bool hyper = _s.hyperConstraintsEnabled();
+  if (!_built || _builtForHyper != hyper) {
+    build(hyper);
+  }
+
+  // Select the rows of the given values. The matrix is restored afterwards,
+  // so these are tracked.
+  int givenNodes[numCells];
+  int numGiven = 0;
+  bool clash = false;
+  for (int i = 0; i < numCells && !clash; i++) {
+    int bit = _s.cellAt(i).getBitValue();
+    if (bit == 0) {
+      continue;
+    }
+
+    int node = _rowNode[i * numValues + bitToValue(bit) - 1];
+
+    // The row is only available when none of its columns has been covered yet.
+    // It can clash while editing, as the implicit hyper-boxes are not enforced
+    // then.
+    int j = node;
+    do {
+      int col = _column[j];
+      clash |= (_right[_left[col]] != col);
+      j = _right[j];
+    } while (j != node);
+
+    if (!clash) {
+      cover(_column[node]);
+      coverRow(node);
+      givenNodes[numGiven++] = node;
+    }
+  }
+
+  if (!clash) {
+    search(0);
+  }
+
+  while (numGiven > 0) {
+    int node = givenNodes[--numGiven];
+    uncoverRow(node);
+    uncover(_column[node]);
+  }
+
+  return _numSolutionsFound;
+}
+
+bool DlxSolver::solve() {
+  if (findSolutions(1) != 1) {
+    return false;
+  }
+
+  for (int i = 0; i < _solutionLen; i++) {
+    int r = _solutionRows[i];
+    _s.setBitValue(_s.cellAt(r / numValues), valueToBit(r % numValues + 1));
+  }
+
+  return true;
+}
+
+bool DlxSolver::isSolvable() {
+  return (findSolutions(1) == 1);
+}
+
+SolutionCount DlxSolver::countSolutions() {
+  return (SolutionCount)findSolutions(2);
+}
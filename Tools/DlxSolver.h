@@ -0,0 +1,90 @@
+/*
+ * Sudoku, a Gamebuino game
+ *
+ * Copyright 2018, Erwin Bonsma
+ */
+
+#ifndef __DLX_SOLVER_INCLUDED
+#define __DLX_SOLVER_INCLUDED
+
+#include "Solver.h"
+#include "Sudoku.h"
+
+/* Solver that uses Knuth's Algorithm X with Dancing Links.
+ *
+ * The puzzle is expressed as an exact cover problem. There is a row for each
+ * cell/value combination. There is a column for each cell (it must have one
+ * value) and for each value in every active constraint group (it must occur
+ * once). For Hyper Sudokus the latter includes the five implicit hyper-boxes.
+ *
+ * It has the same public interface as Solver. The puzzle is only modified by
+ * solve(), which fills in the solution found.
+ */
+class DlxSolver {
+  static const int maxColumns = numCells + numConstraintGroups * numValues;
+  static const int numMatrixRows = numCells * numValues;
+  static const int maxNodes = (
+    1 + maxColumns + numMatrixRows * (1 + maxConstraintsPerCell)
+  );
+
+  // The puzzle to solve
+  Sudoku& _s;
+
+  // Whether the matrix has been built, and for which puzzle type
+  bool _built;
+  bool _builtForHyper;
+
+  // The matrix. Node zero is the root, followed by the column headers, and
+  // then by the nodes of each row.
+  int _left[maxNodes];
+  int _right[maxNodes];
+  int _up[maxNodes];
+  int _down[maxNodes];
+  int _column[maxNodes];
+  int _row[maxNodes];
+  int _size[maxColumns + 1];
+
+  // The first node of each row
+  int _rowNode[numMatrixRows];
+
+  // Rows in the current partial solution
+  int _selectedRows[numCells];
+
+  // The rows of the first solution that was found
+  int _solutionRows[numCells];
+  int _solutionLen;
+
+  int _numSolutionsToFind;
+  int _numSolutionsFound;
+
+  // Search statistics of the last solve (see Solver)
+  int _numNodes;
+  int _numBacktracks;
+
+  void build(bool hyper);
+
+  void cover(int col);
+  void uncover(int col);
+
+  void coverRow(int node);
+  void uncoverRow(int node);
+
+  // Returns "true" if the termination criterion has been reached.
+  bool search(int depth);
+
+  int findSolutions(int numSolutionsToFind);
+
+public:
+  DlxSolver(Sudoku& s);
+
+  Sudoku& sudoku() { return _s; }
+
+  bool solve();
+  bool isSolvable();
+  SolutionCount countSolutions();
+
+  int numNodes() { return _numNodes; }
+  int numBacktracks() { return _numBacktracks; }
+};
+
+#endif
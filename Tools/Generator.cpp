@@ -0,0 +1,293 @@
+/*
+ * Sudoku, a Gamebuino game
+ *
+ * Copyright 2018, Erwin Bonsma
+ */
+
+/* Headless puzzle generator for the host.
+ *
+ * It runs the same pipeline as startPuzzleGeneration() in Sudoku.ino, i.e. a
+ * random solve followed by a random strip, in a tight loop. Each generated
+ * puzzle is written as a single line (see PuzzleIO.h). Throughput is reported
+ * on stderr when done.
+ *
+ * Puzzles can be generated for one or more difficulty bands (see Grader.h).
+ * For each band, candidates are generated until the requested number of
+ * puzzles is within the band. The acceptance rate is reported per band.
+ *
+ * Generation can be spread over multiple worker threads. Each has its own
+ * Sudoku, Solver and Stripper, with a separately seeded random generator. The
+ * workers hand their puzzles to the main thread, which writes them, via a
+ * lock-free queue.
+ *
+ * Usage: generator [-n count] [-j threads] [-y] [-a] [-m] [-c clues]
+ *                  [-x nodes] [-d min:max] [-s seed] [-o file] [-b bank] [-q]
+ *   -n  Number of puzzles to generate, per difficulty band (default: 100)
+ *   -j  Number of worker threads (default: 1)
+ *   -y  Generate Hyper Sudokus
+ *   -a  Check uniqueness while stripping by trying each alternative value,
+ *       instead of searching once for a second solution (for comparison)
+ *   -m  Let the solver branch on the cell with the fewest possible values. This
+ *       is needed to generate 25x25 puzzles in reasonable time.
+ *   -c  Stop stripping at the given number of clues, so that puzzles are unique
+ *       but not minimal (default: strip completely)
+ *   -x  Limit each uniqueness check while stripping to the given number of
+ *       solver nodes. Values whose check runs out are kept, so puzzles are
+ *       unique but not always minimal (default: no limit)
+ *   -d  Difficulty band, as minimum and maximum grader score. It can be given
+ *       multiple times (default: any difficulty)
+ *   -s  Seed for the random generators (default: based on time)
+ *   -o  Output file (default: stdout)
+ *   -b  Append the puzzles, with their grades, to the given bank instead (see
+ *       PuzzleBank.h). It is created when it does not yet exist.
+ *   -q  Quiet, do not output the puzzles (for measuring throughput only)
+ */
+
+#include <atomic>
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <thread>
+#include <time.h>
+#include <unistd.h>
+#include <vector>
+
+#include "Grader.h"
+#include "Sudoku.h"
+#include "Solver.h"
+#include "Stripper.h"
+#include "Utils.h"
+
+#include "OutputQueue.h"
+#include "PuzzleBank.h"
+#include "PuzzleIO.h"
+
+struct GeneratedPuzzle {
+  char line[puzzleLineLen + 1];
+  int numClues;
+
+  // Only set when writing to a bank
+  int score;
+  Technique hardest;
+};
+
+OutputQueue<GeneratedPuzzle, 1024> outputQueue;
+
+// The number of puzzles that still need to be claimed by a worker
+std::atomic<int> numUnclaimed;
+
+// The number of generated candidates, including those outside the band
+std::atomic<int> numCandidates;
+
+// Set to check uniqueness by trying each alternative value
+bool tryAlternatives = false;
+
+BranchOrder branchOrder = BranchOrder::CellIndex;
+int minClues = 0;
+int maxCheckNodes = 0;
+
+// Set when the puzzles are appended to a bank
+PuzzleBankWriter* bank = NULL;
+
+// The band is NULL when any difficulty is fine
+void generatePuzzles(bool hyper, const DifficultyBand* band, uint32_t seed) {
+  Sudoku sudoku;
+  Solver solver(sudoku);
+  Stripper stripper(sudoku, solver);
+  Grader grader(sudoku);
+
+  sudoku.init();
+  solver.seedRandom(seed);
+  stripper.setFindSecondSolution(!tryAlternatives);
+  solver.setBranchOrder(branchOrder);
+  stripper.setMinClues(minClues);
+  stripper.setMaxCheckNodes(maxCheckNodes);
+  if (band != NULL) {
+    stripper.setDifficultyBand(&grader, *band);
+  }
+
+  GeneratedPuzzle puzzle;
+  while (numUnclaimed.fetch_sub(1) > 0) {
+    do {
+      sudoku.reset(hyper);
+      assertTrue(solver.randomSolve());
+      numCandidates++;
+    } while (!stripper.randomStrip());
+
+    formatPuzzleLine(sudoku, puzzle.line);
+    puzzle.numClues = sudoku.numFilled();
+    if (bank != NULL) {
+      puzzle.score = grader.grade();
+      puzzle.hardest = grader.hardestTechnique();
+    }
+
+    while (!outputQueue.tryPush(puzzle)) {
+      std::this_thread::yield();
+    }
+  }
+}
+
+void usage(const char* name) {
+  fprintf(
+    stderr,
+    "Usage: %s [-n count] [-j threads] [-y] [-a] [-m] [-c clues] [-x nodes] [-d min:max] "
+    "[-s seed] [-o file] [-b bank] [-q]\n",
+    name
+  );
+  exit(EXIT_FAILURE);
+}
+
+// Generates the puzzles for one band and reports the throughput. Returns false
+// when writing failed.
+bool generateBand(
+  int numPuzzles, int numThreads, bool hyper, const DifficultyBand* band,
+  uint32_t seed, FILE* out, bool quiet
+) {
+  numUnclaimed = numPuzzles;
+  numCandidates = 0;
+
+  auto start = std::chrono::steady_clock::now();
+
+  std::vector<std::thread> workers;
+  for (int i = 0; i < numThreads; i++) {
+    // Spread the seeds so that workers do not generate the same puzzles
+    workers.emplace_back(generatePuzzles, hyper, band, seed + 0x9e3779b9 * (uint32_t)i);
+  }
+
+  int totalClues = 0;
+  int numWritten = 0;
+  bool ok = true;
+  GeneratedPuzzle puzzle;
+  Sudoku sudoku;
+  sudoku.init();
+  while (numWritten < numPuzzles) {
+    if (!outputQueue.tryPop(puzzle)) {
+      std::this_thread::yield();
+      continue;
+    }
+
+    totalClues += puzzle.numClues;
+    numWritten++;
+    if (!quiet && ok && bank != NULL) {
+      // Converting back from text keeps the queue entries small
+      assertTrue(parsePuzzleLine(puzzle.line, sudoku, hyper));
+      if (!bank->append(sudoku, puzzle.score, puzzle.hardest)) {
+        perror("write");
+        ok = false;
+      }
+    } else if (!quiet && ok) {
+      puzzle.line[puzzleLineLen] = '\n';
+      if (fwrite(puzzle.line, 1, puzzleLineLen + 1, out) != puzzleLineLen + 1) {
+        perror("write");
+        ok = false;
+      }
+    }
+  }
+
+  for (auto& worker : workers) {
+    worker.join();
+  }
+  if (ok && bank != NULL && !bank->flush()) {
+    perror("write");
+    ok = false;
+  }
+
+  std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+  char bandInfo[64] = "";
+  if (band != NULL) {
+    snprintf(
+      bandInfo, sizeof(bandInfo), " with score %d:%d", band->minScore, band->maxScore
+    );
+  }
+  fprintf(
+    stderr,
+    "Generated %d %s %dx%d puzzles%s in %.3f s using %d thread(s) "
+    "(%.1f puzzles/s, %.1f clues/puzzle, %d candidates, %.1f%% accepted)\n",
+    numPuzzles, hyper ? "hyper" : "normal", numCols, numRows, bandInfo,
+    elapsed.count(), numThreads, numPuzzles / elapsed.count(),
+    numPuzzles > 0 ? (double)totalClues / numPuzzles : 0.0,
+    (int)numCandidates,
+    numCandidates > 0 ? 100.0 * numPuzzles / numCandidates : 0.0
+  );
+
+  return ok;
+}
+
+int main(int argc, char* argv[]) {
+  int numPuzzles = 100;
+  int numThreads = 1;
+  bool hyper = false;
+  bool quiet = false;
+  uint32_t seed = (uint32_t)time(NULL);
+  const char* outFile = NULL;
+  const char* bankFile = NULL;
+  std::vector<DifficultyBand> bands;
+  DifficultyBand band;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "n:j:yamc:x:d:s:o:b:q")) != -1) {
+    switch (opt) {
+      case 'n': numPuzzles = atoi(optarg); break;
+      case 'j': numThreads = atoi(optarg); break;
+      case 'y': hyper = true; break;
+      case 'a': tryAlternatives = true; break;
+      case 'm': branchOrder = BranchOrder::MinRemaining; break;
+      case 'c': minClues = atoi(optarg); break;
+      case 'x': maxCheckNodes = atoi(optarg); break;
+      case 'd':
+        if (sscanf(optarg, "%d:%d", &band.minScore, &band.maxScore) != 2) {
+          usage(argv[0]);
+        }
+        bands.push_back(band);
+        break;
+      case 's': seed = (uint32_t)strtoul(optarg, NULL, 10); break;
+      case 'o': outFile = optarg; break;
+      case 'b': bankFile = optarg; break;
+      case 'q': quiet = true; break;
+      default: usage(argv[0]);
+    }
+  }
+  if (numThreads < 1) {
+    usage(argv[0]);
+  }
+  if (hyper && !hyperSupported) {
+    fprintf(stderr, "Hyper Sudokus are only supported for 9x9 puzzles\n");
+    return EXIT_FAILURE;
+  }
+
+  FILE* out = stdout;
+  if (outFile != NULL) {
+    out = fopen(outFile, "w");
+    if (out == NULL) {
+      perror(outFile);
+      return EXIT_FAILURE;
+    }
+  }
+
+  PuzzleBankWriter bankWriter;
+  if (bankFile != NULL) {
+    if (!bankWriter.open(bankFile)) {
+      return EXIT_FAILURE;
+    }
+    bank = &bankWriter;
+  }
+
+  bool ok = true;
+  if (bands.empty()) {
+    ok = generateBand(numPuzzles, numThreads, hyper, NULL, seed, out, quiet);
+  }
+  for (size_t i = 0; i < bands.size() && ok; i++) {
+    ok = generateBand(numPuzzles, numThreads, hyper, &bands[i], seed, out, quiet);
+  }
+
+  if (out != stdout) {
+    fclose(out);
+  }
+  if (bank != NULL && !bankWriter.close()) {
+    perror(bankFile);
+    ok = false;
+  }
+
+  return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+}
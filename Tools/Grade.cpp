@@ -0,0 +1,134 @@
+/*
+ * Sudoku, a Gamebuino game
+ *
+ * Copyright 2018, Erwin Bonsma
+ */
+
+/* Grades the difficulty of puzzles.
+ *
+ * It reads puzzles (see PuzzleReader.h for the formats) from the given files,
+ * or one per line from stdin when there are none. For each it writes the puzzle, its score
+ * and the hardest technique needed to solve it (see Grader.h). When done, it
+ * reports the throughput and the number of puzzles per hardest technique on
+ * stderr.
+ *
+ * Usage: grader [-y] [-q] [file...]
+ *   -y  Treat the puzzles as Hyper Sudokus
+ *   -q  Quiet, only report the summary
+ */
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "Sudoku.h"
+#include "Grader.h"
+
+#include "PuzzleIO.h"
+#include "PuzzleReader.h"
+
+int numGraded = 0;
+long totalScore = 0;
+int numHardest[numTechniques];
+std::chrono::duration<double> gradeTime(0);
+
+void gradePuzzle(Grader& grader, Sudoku& sudoku, bool quiet) {
+  auto start = std::chrono::steady_clock::now();
+  int score = grader.grade();
+  gradeTime += std::chrono::steady_clock::now() - start;
+
+  Technique hardest = grader.hardestTechnique();
+  numGraded++;
+  totalScore += score;
+  numHardest[(int)hardest]++;
+
+  if (!quiet) {
+    char line[puzzleLineLen + 1];
+    formatPuzzleLine(sudoku, line);
+    printf("%s %d %s\n", line, score, techniqueName(hardest));
+  }
+}
+
+bool gradePuzzles(FILE* in, const char* name, bool hyper, bool quiet) {
+  Sudoku sudoku;
+  Grader grader(sudoku);
+  sudoku.init();
+
+  while (readPuzzleLine(in, sudoku, hyper)) {
+    gradePuzzle(grader, sudoku, quiet);
+  }
+
+  if (!feof(in)) {
+    fprintf(stderr, "%s: invalid puzzle after %d puzzles\n", name, numGraded);
+    return false;
+  }
+  return true;
+}
+
+bool gradeFile(const char* filename, bool hyper, bool quiet) {
+  PuzzleReader reader;
+  if (!reader.open(filename)) {
+    return false;
+  }
+
+  Sudoku sudoku;
+  Grader grader(sudoku);
+  sudoku.init();
+
+  while (reader.next(sudoku, hyper)) {
+    gradePuzzle(grader, sudoku, quiet);
+  }
+
+  if (reader.failed()) {
+    fprintf(stderr, "%s: invalid puzzle after %d puzzles\n", filename, reader.numRead());
+    return false;
+  }
+  return true;
+}
+
+void usage(const char* name) {
+  fprintf(stderr, "Usage: %s [-y] [-q] [file...]\n", name);
+  exit(EXIT_FAILURE);
+}
+
+int main(int argc, char* argv[]) {
+  bool hyper = false;
+  bool quiet = false;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "yq")) != -1) {
+    switch (opt) {
+      case 'y': hyper = true; break;
+      case 'q': quiet = true; break;
+      default: usage(argv[0]);
+    }
+  }
+  if (hyper && !hyperSupported) {
+    fprintf(stderr, "Hyper Sudokus are only supported for 9x9 puzzles\n");
+    return EXIT_FAILURE;
+  }
+
+  if (optind == argc) {
+    if (!gradePuzzles(stdin, "stdin", hyper, quiet)) {
+      return EXIT_FAILURE;
+    }
+  }
+  for (int i = optind; i < argc; i++) {
+    if (!gradeFile(argv[i], hyper, quiet)) {
+      return EXIT_FAILURE;
+    }
+  }
+
+  fprintf(
+    stderr, "Graded %d puzzles in %.3f s (%.1f puzzles/s, %.1f average score)\n",
+    numGraded, gradeTime.count(),
+    gradeTime.count() > 0 ? numGraded / gradeTime.count() : 0.0,
+    numGraded > 0 ? (double)totalScore / numGraded : 0.0
+  );
+  for (int i = 0; i < numTechniques; i++) {
+    fprintf(stderr, "  %-18s %6d\n", techniqueName((Technique)i), numHardest[i]);
+  }
+
+  return EXIT_SUCCESS;
+}
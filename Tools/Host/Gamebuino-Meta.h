@@ -0,0 +1,21 @@
+/*
+ * Sudoku, a Gamebuino game
+ *
+ * Copyright 2018, Erwin Bonsma
+ */
+
+/* Stand-in for the Gamebuino library when building the puzzle engine (Sudoku,
+ * Solver and Stripper) for the host. It only provides the standard headers
+ * that the engine relies on. Anything that needs the actual device (display,
+ * sound, save blocks) is not part of the host build.
+ */
+
+#ifndef __GAMEBUINO_META_HOST_INCLUDED
+#define __GAMEBUINO_META_HOST_INCLUDED
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#endif
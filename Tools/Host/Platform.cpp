@@ -0,0 +1,30 @@
+/*
+ * Sudoku, a Gamebuino game
+ *
+ * Copyright 2018, Erwin Bonsma
+ */
+
+/* Host implementation of the device-specific functions in Sudoku/Platform.cpp
+ */
+
+#include <Gamebuino-Meta.h>
+
+#include <chrono>
+
+#include "Utils.h"
+
+void initDebugLog() {}
+
+uint32_t timeMicros() {
+  return (uint32_t)std::chrono::duration_cast<std::chrono::microseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()
+  ).count();
+}
+
+void assertFailed(const char *function, const char *file, int lineNo, const char *expression) {
+  fprintf(
+    stderr, "=== ASSERT FAILED ===\n%s\n%s\n%d\n%s\n",
+    function, file, lineNo, expression
+  );
+  abort();
+}
@@ -0,0 +1,13 @@
+/*
+ * Sudoku, a Gamebuino game
+ *
+ * Copyright 2018, Erwin Bonsma
+ */
+
+/* Host implementation of Sudoku/Progress.cpp. There is no screen to update, so
+ * progress is silently ignored.
+ */
+
+#include "Progress.h"
+
+void signalPuzzleGenerationProgress(int numSteps, int maxSteps) {}
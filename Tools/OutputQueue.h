@@ -0,0 +1,87 @@
+/*
+ * Sudoku, a Gamebuino game
+ *
+ * Copyright 2018, Erwin Bonsma
+ */
+
+#ifndef __OUTPUT_QUEUE_INCLUDED
+#define __OUTPUT_QUEUE_INCLUDED
+
+#include <atomic>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Bounded lock-free multi-producer multi-consumer queue.
+ *
+ * Each slot carries a sequence number that tells whether it is ready to be
+ * written or read for a given position, so producers and consumers only
+ * contend on a single atomic position counter each. The capacity must be a
+ * power of two.
+ */
+template <typename T, size_t capacity>
+class OutputQueue {
+  static_assert((capacity & (capacity - 1)) == 0, "Capacity must be power of two");
+
+  struct Slot {
+    std::atomic<size_t> sequence;
+    T item;
+  };
+
+  Slot _slots[capacity];
+
+  // Kept on separate cache lines to avoid false sharing between producers and
+  // consumers
+  alignas(64) std::atomic<size_t> _pushPos;
+  alignas(64) std::atomic<size_t> _popPos;
+
+public:
+  OutputQueue() : _pushPos(0), _popPos(0) {
+    for (size_t i = 0; i < capacity; i++) {
+      _slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+  }
+
+  // Returns false when the queue is full
+  bool tryPush(const T& item) {
+    size_t pos = _pushPos.load(std::memory_order_relaxed);
+    while (true) {
+      Slot& slot = _slots[pos & (capacity - 1)];
+      size_t seq = slot.sequence.load(std::memory_order_acquire);
+      intptr_t diff = (intptr_t)seq - (intptr_t)pos;
+      if (diff == 0) {
+        if (_pushPos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          slot.item = item;
+          slot.sequence.store(pos + 1, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = _pushPos.load(std::memory_order_relaxed);
+      }
+    }
+  }
+
+  // Returns false when the queue is empty
+  bool tryPop(T& item) {
+    size_t pos = _popPos.load(std::memory_order_relaxed);
+    while (true) {
+      Slot& slot = _slots[pos & (capacity - 1)];
+      size_t seq = slot.sequence.load(std::memory_order_acquire);
+      intptr_t diff = (intptr_t)seq - (intptr_t)(pos + 1);
+      if (diff == 0) {
+        if (_popPos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+          item = slot.item;
+          slot.sequence.store(pos + capacity, std::memory_order_release);
+          return true;
+        }
+      } else if (diff < 0) {
+        return false;
+      } else {
+        pos = _popPos.load(std::memory_order_relaxed);
+      }
+    }
+  }
+};
+
+#endif
@@ -0,0 +1,279 @@
+/*
+ * Sudoku, a Gamebuino game
+ *
+ * Copyright 2018, Erwin Bonsma
+ */
+
+#include "PuzzleBank.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "Utils.h"
+
+const char bankMagic[4] = { 'S', 'D', 'K', 'B' };
+
+const int countOffset = 8;
+const int cellsOffset = 3;
+
+uint32_t readUint32(const uint8_t* p) {
+  return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+void writeUint32(uint8_t* p, uint32_t value) {
+  for (int i = 0; i < 4; i++) {
+    p[i] = (uint8_t)(value >> (8 * i));
+  }
+}
+
+void initHeader(uint8_t* header, uint32_t count) {
+  memset(header, 0, bankHeaderSize);
+  memcpy(header, bankMagic, sizeof(bankMagic));
+  header[4] = bankFormatVersion;
+  header[5] = boxSize;
+  header[6] = (uint8_t)bankRecordSize;
+  header[7] = (uint8_t)(bankRecordSize >> 8);
+  writeUint32(header + countOffset, count);
+}
+
+bool checkHeader(const uint8_t* header, const char* filename) {
+  if (memcmp(header, bankMagic, sizeof(bankMagic)) != 0) {
+    fprintf(stderr, "%s: not a puzzle bank\n", filename);
+    return false;
+  }
+  if (header[4] != bankFormatVersion) {
+    fprintf(stderr, "%s: unsupported version %d\n", filename, header[4]);
+    return false;
+  }
+  if (header[5] != boxSize || (header[6] | (header[7] << 8)) != bankRecordSize) {
+    fprintf(stderr, "%s: bank has box size %d, expected %d\n", filename, header[5], boxSize);
+    return false;
+  }
+  return true;
+}
+
+void packRecord(Sudoku& sudoku, int score, Technique hardest, uint8_t* record) {
+  record[0] = (uint8_t)hardest;
+  if (sudoku.hyperConstraintsEnabled()) {
+    record[0] |= bankHyperFlag;
+  }
+  if (score > 0xffff) {
+    score = 0xffff;
+  }
+  record[1] = (uint8_t)score;
+  record[2] = (uint8_t)(score >> 8);
+
+  uint8_t* p = record + cellsOffset;
+  uint32_t bits = 0;
+  int numBits = 0;
+  for (int i = 0; i < numCells; i++) {
+    bits |= (uint32_t)bitToValue(sudoku.cellAt(i).getBitValue()) << numBits;
+    numBits += bankBitsPerCell;
+    while (numBits >= 8) {
+      *p++ = (uint8_t)bits;
+      bits >>= 8;
+      numBits -= 8;
+    }
+  }
+  if (numBits > 0) {
+    *p = (uint8_t)bits;
+  }
+}
+
+//------------------------------------------------------------------------------
+// PuzzleBank
+
+PuzzleBank::PuzzleBank() : _data(NULL), _size(0), _count(0) {}
+
+PuzzleBank::~PuzzleBank() {
+  close();
+}
+
+bool PuzzleBank::open(const char* filename) {
+  close();
+
+  int fd = ::open(filename, O_RDONLY);
+  if (fd < 0) {
+    perror(filename);
+    return false;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    perror(filename);
+    ::close(fd);
+    return false;
+  }
+  if (st.st_size < bankHeaderSize) {
+    fprintf(stderr, "%s: not a puzzle bank\n", filename);
+    ::close(fd);
+    return false;
+  }
+
+  void* data = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (data == MAP_FAILED) {
+    perror(filename);
+    return false;
+  }
+  _data = (const uint8_t*)data;
+  _size = st.st_size;
+
+  if (!checkHeader(_data, filename)) {
+    close();
+    return false;
+  }
+
+  // Only count records that are completely present
+  _count = readUint32(_data + countOffset);
+  uint32_t numPresent = (uint32_t)((_size - bankHeaderSize) / bankRecordSize);
+  if (_count > numPresent) {
+    _count = numPresent;
+  }
+
+  return true;
+}
+
+void PuzzleBank::close() {
+  if (_data != NULL) {
+    munmap((void*)_data, _size);
+    _data = NULL;
+  }
+  _size = 0;
+  _count = 0;
+}
+
+bool hasBankMagic(const uint8_t* data, size_t size) {
+  return size >= sizeof(bankMagic) && memcmp(data, bankMagic, sizeof(bankMagic)) == 0;
+}
+
+BankEntry PuzzleBank::read(uint32_t index, uint8_t* values) {
+  assertTrue(index < _count);
+  const uint8_t* record = _data + bankHeaderSize + (size_t)index * bankRecordSize;
+
+  BankEntry entry;
+  entry.hyper = (record[0] & bankHyperFlag) != 0;
+  entry.hardest = (Technique)(record[0] & 0x0f);
+  entry.score = record[1] | (record[2] << 8);
+
+  const uint8_t* p = record + cellsOffset;
+  uint32_t bits = 0;
+  int numBits = 0;
+  for (int i = 0; i < numCells; i++) {
+    while (numBits < bankBitsPerCell) {
+      bits |= (uint32_t)*p++ << numBits;
+      numBits += 8;
+    }
+    values[i] = (uint8_t)(bits & ((1 << bankBitsPerCell) - 1));
+    bits >>= bankBitsPerCell;
+    numBits -= bankBitsPerCell;
+  }
+
+  return entry;
+}
+
+BankEntry PuzzleBank::read(uint32_t index, Sudoku& sudoku) {
+  uint8_t values[numCells];
+
+  BankEntry entry = read(index, values);
+  sudoku.reset(entry.hyper, values);
+
+  return entry;
+}
+
+//------------------------------------------------------------------------------
+// PuzzleBankWriter
+
+PuzzleBankWriter::PuzzleBankWriter() : _file(NULL), _count(0) {}
+
+PuzzleBankWriter::~PuzzleBankWriter() {
+  close();
+}
+
+bool PuzzleBankWriter::open(const char* filename) {
+  uint8_t header[bankHeaderSize];
+
+  _file = fopen(filename, "r+b");
+  if (_file == NULL && errno == ENOENT) {
+    // Create a new, empty bank
+    _file = fopen(filename, "w+b");
+    if (_file != NULL) {
+      initHeader(header, 0);
+      if (fwrite(header, 1, bankHeaderSize, _file) != (size_t)bankHeaderSize) {
+        perror(filename);
+        close();
+        return false;
+      }
+    }
+  } else if (_file != NULL) {
+    if (fread(header, 1, bankHeaderSize, _file) != (size_t)bankHeaderSize) {
+      fprintf(stderr, "%s: not a puzzle bank\n", filename);
+      close();
+      return false;
+    }
+    if (!checkHeader(header, filename)) {
+      close();
+      return false;
+    }
+  }
+  if (_file == NULL) {
+    perror(filename);
+    return false;
+  }
+
+  _count = readUint32(header + countOffset);
+
+  // Append after the last counted record
+  if (fseek(_file, bankHeaderSize + (long)_count * bankRecordSize, SEEK_SET) != 0) {
+    perror(filename);
+    close();
+    return false;
+  }
+
+  return true;
+}
+
+bool PuzzleBankWriter::append(Sudoku& sudoku, int score, Technique hardest) {
+  uint8_t record[bankRecordSize];
+
+  packRecord(sudoku, score, hardest, record);
+  if (fwrite(record, 1, bankRecordSize, _file) != (size_t)bankRecordSize) {
+    return false;
+  }
+  _count++;
+
+  return true;
+}
+
+bool PuzzleBankWriter::writeCount() {
+  uint8_t count[4];
+  writeUint32(count, _count);
+
+  return (
+    fseek(_file, countOffset, SEEK_SET) == 0 &&
+    fwrite(count, 1, sizeof(count), _file) == sizeof(count) &&
+    fflush(_file) == 0 &&
+    fseek(_file, bankHeaderSize + (long)_count * bankRecordSize, SEEK_SET) == 0
+  );
+}
+
+bool PuzzleBankWriter::flush() {
+  // The records should be written before the count that includes them
+  return fflush(_file) == 0 && writeCount();
+}
+
+bool PuzzleBankWriter::close() {
+  if (_file == NULL) {
+    return true;
+  }
+
+  bool ok = flush();
+  ok &= (fclose(_file) == 0);
+  _file = NULL;
+
+  return ok;
+}
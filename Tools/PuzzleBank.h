@@ -0,0 +1,105 @@
+/*
+ * Sudoku, a Gamebuino game
+ *
+ * Copyright 2018, Erwin Bonsma
+ */
+
+#ifndef __PUZZLE_BANK_INCLUDED
+#define __PUZZLE_BANK_INCLUDED
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "Grader.h"
+#include "Sudoku.h"
+
+/* Bank file format
+ *
+ * A bank stores many puzzles compactly, with constant-time access to each.
+ *
+ * Header (bankHeaderSize bytes, multi-byte fields are little-endian):
+ *   0  Magic "SDKB"
+ *   4  Format version (uint8)
+ *   5  Box size (uint8), which should match the one of the build
+ *   6  Record size in bytes (uint16)
+ *   8  Number of records (uint32)
+ *  12  Reserved (zero)
+ *
+ * The header is followed by the records, each of the same size:
+ *   0  Mode: bit 7 is set for Hyper Sudokus, bits 0-3 hold the hardest
+ *      technique needed to solve it (see Grader.h)
+ *   1  Grader score (uint16), capped at 65535
+ *   3  The cell values in row-major order, packed at bankBitsPerCell bits each
+ *      starting at the lowest bit, with zero for empty cells
+ *
+ * Appending writes the records first and then updates the count in the header.
+ * Records beyond the count, e.g. after an interrupted append, are ignored and
+ * overwritten by the next append.
+ */
+const int bankHeaderSize = 16;
+const int bankFormatVersion = 1;
+
+const int bankBitsPerCell = (numValues < 16) ? 4 : (numValues < 32) ? 5 : 6;
+const int bankRecordSize = 3 + (numCells * bankBitsPerCell + 7) / 8;
+
+const uint8_t bankHyperFlag = 0x80;
+
+// Returns true when the data starts like a bank does
+bool hasBankMagic(const uint8_t* data, size_t size);
+
+struct BankEntry {
+  bool hyper;
+  int score;
+  Technique hardest;
+};
+
+// Read access to a bank. The file is memory-mapped.
+class PuzzleBank {
+  const uint8_t* _data;
+  size_t _size;
+  uint32_t _count;
+
+public:
+  PuzzleBank();
+  ~PuzzleBank();
+
+  // Opens the bank. Returns false, after reporting why, when it fails.
+  bool open(const char* filename);
+  void close();
+
+  uint32_t count() { return _count; }
+
+  // Sets the puzzle to the given entry and returns its details.
+  BankEntry read(uint32_t index, Sudoku& sudoku);
+
+  // Unpacks the values of the given entry (see Sudoku::reset) and returns its
+  // details.
+  BankEntry read(uint32_t index, uint8_t* values);
+};
+
+// Appends puzzles to a bank, creating it when needed.
+class PuzzleBankWriter {
+  FILE* _file;
+  uint32_t _count;
+
+  bool writeCount();
+
+public:
+  PuzzleBankWriter();
+  ~PuzzleBankWriter();
+
+  // Opens the bank. Returns false, after reporting why, when it fails.
+  bool open(const char* filename);
+
+  bool append(Sudoku& sudoku, int score, Technique hardest);
+
+  // Makes the appended puzzles part of the bank.
+  bool flush();
+
+  // Flushes and closes the bank.
+  bool close();
+
+  uint32_t count() { return _count; }
+};
+
+#endif
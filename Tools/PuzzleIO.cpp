@@ -0,0 +1,113 @@
+/*
+ * Sudoku, a Gamebuino game
+ *
+ * Copyright 2018, Erwin Bonsma
+ */
+
+#include "PuzzleIO.h"
+
+#include <string.h>
+
+#include "Utils.h"
+
+const char* techniqueNames[numTechniques] = {
+  "naked-single", "hidden-single", "locked-candidates", "naked-pair",
+  "hidden-pair", "naked-triple", "hidden-triple", "x-wing", "guess"
+};
+
+char valueToChar(int value) {
+  return (char)((value <= 9) ? '0' + value : 'A' + value - 10);
+}
+
+int charToValue(char ch) {
+  int value = 0;
+  if (ch >= '1' && ch <= '9') {
+    value = ch - '0';
+  } else if (ch >= 'A' && ch <= 'Z') {
+    value = ch - 'A' + 10;
+  } else if (ch >= 'a' && ch <= 'z') {
+    value = ch - 'a' + 10;
+  }
+  return (value <= numValues) ? value : 0;
+}
+
+void formatPuzzleLine(Sudoku& sudoku, char* line) {
+  for (int i = 0; i < numCells; i++) {
+    int bit = sudoku.cellAt(i).getBitValue();
+    line[i] = (bit == 0) ? '.' : valueToChar(bitToValue(bit));
+  }
+  line[puzzleLineLen] = '\0';
+}
+
+bool writePuzzleLine(FILE* out, Sudoku& sudoku) {
+  char line[puzzleLineLen + 2];
+
+  formatPuzzleLine(sudoku, line);
+  line[puzzleLineLen] = '\n';
+
+  return fwrite(line, 1, puzzleLineLen + 1, out) == (size_t)(puzzleLineLen + 1);
+}
+
+void formatPuzzleValues(const uint8_t* values, char* line) {
+  for (int i = 0; i < numCells; i++) {
+    line[i] = (values[i] == 0) ? '.' : valueToChar(values[i]);
+  }
+  line[puzzleLineLen] = '\0';
+}
+
+bool writePuzzleValues(FILE* out, const uint8_t* values) {
+  char line[puzzleLineLen + 2];
+
+  formatPuzzleValues(values, line);
+  line[puzzleLineLen] = '\n';
+
+  return fwrite(line, 1, puzzleLineLen + 1, out) == (size_t)(puzzleLineLen + 1);
+}
+
+bool parsePuzzleValues(const char* line, uint8_t* values) {
+  for (int i = 0; i < numCells; i++) {
+    char ch = line[i];
+    if (ch == '.' || ch == '0') {
+      values[i] = 0;
+      continue;
+    }
+    int value = charToValue(ch);
+    if (value == 0) {
+      return false;
+    }
+    values[i] = (uint8_t)value;
+  }
+
+  return true;
+}
+
+bool parsePuzzleLine(const char* line, Sudoku& sudoku, bool hyperConstraints) {
+  uint8_t values[numCells];
+
+  if (!parsePuzzleValues(line, values)) {
+    sudoku.reset(hyperConstraints);
+    return false;
+  }
+  return sudoku.reset(hyperConstraints, values);
+}
+
+bool readPuzzleLine(FILE* in, Sudoku& sudoku, bool hyperConstraints) {
+  // Leave room for long comment lines and line endings
+  char line[puzzleLineLen + 256];
+
+  while (fgets(line, sizeof(line), in) != NULL) {
+    if (line[0] == '#' || line[0] == '\n' || line[0] == '\r') {
+      continue;
+    }
+    if (strlen(line) < (size_t)puzzleLineLen) {
+      return false;
+    }
+    return parsePuzzleLine(line, sudoku, hyperConstraints);
+  }
+
+  return false;
+}
+
+const char* techniqueName(Technique technique) {
+  return techniqueNames[(int)technique];
+}
@@ -0,0 +1,61 @@
+/*
+ * Sudoku, a Gamebuino game
+ *
+ * Copyright 2018, Erwin Bonsma
+ */
+
+#ifndef __PUZZLE_IO_INCLUDED
+#define __PUZZLE_IO_INCLUDED
+
+#include <stdio.h>
+
+#include "Grader.h"
+#include "Sudoku.h"
+
+/* Line format
+ *
+ * A puzzle is stored as a single line of numCells characters, one per cell in
+ * row-major order. Set cells contain their value, empty cells a '.'. When
+ * reading, a '0' is also accepted for empty cells. For larger puzzles, values
+ * above nine are written as letters, starting with 'A' for ten. When reading,
+ * lower-case letters are accepted as well.
+ */
+const int puzzleLineLen = numCells;
+
+// Conversion of a value (1..numValues) to and from its character. The latter
+// returns zero if the character is not a valid value.
+char valueToChar(int value);
+int charToValue(char ch);
+
+// Formats the puzzle into the buffer, which should hold puzzleLineLen + 1 chars
+void formatPuzzleLine(Sudoku& sudoku, char* line);
+
+bool writePuzzleLine(FILE* out, Sudoku& sudoku);
+
+// As above, for packed values, one per cell with zero for empty cells (see
+// Sudoku::reset)
+void formatPuzzleValues(const uint8_t* values, char* line);
+
+bool writePuzzleValues(FILE* out, const uint8_t* values);
+
+/* Converts the line to packed values, one per cell with zero for empty cells
+ * (see Sudoku::reset). Returns false if the line is malformed. The values are
+ * not checked against the constraints.
+ */
+bool parsePuzzleValues(const char* line, uint8_t* values);
+
+/* Resets the puzzle and sets the values of the given line. Returns false if the
+ * line is malformed or a value violates one of the constraints.
+ */
+bool parsePuzzleLine(const char* line, Sudoku& sudoku, bool hyperConstraints);
+
+/* Reads the next puzzle from the file. Empty lines and lines starting with a
+ * '#' are skipped. Returns false at the end of the file or when the line is
+ * not a valid puzzle. PuzzleReader is faster, but requires a regular file.
+ */
+bool readPuzzleLine(FILE* in, Sudoku& sudoku, bool hyperConstraints);
+
+// The name of the technique as shown in reports, e.g. "hidden-single"
+const char* techniqueName(Technique technique);
+
+#endif
@@ -0,0 +1,141 @@
+/*
+ * Sudoku, a Gamebuino game
+ *
+ * Copyright 2018, Erwin Bonsma
+ */
+
+#include "PuzzleReader.h"
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "PuzzleIO.h"
+
+PuzzleReader::PuzzleReader()
+  : _format(PuzzleFormat::Line), _data(NULL), _size(0), _pos(0), _nextEntry(0),
+    _numRead(0), _failed(false) {}
+
+PuzzleReader::~PuzzleReader() {
+  close();
+}
+
+bool PuzzleReader::open(const char* filename) {
+  close();
+
+  int fd = ::open(filename, O_RDONLY);
+  if (fd < 0) {
+    perror(filename);
+    return false;
+  }
+
+  struct stat st;
+  if (fstat(fd, &st) != 0) {
+    perror(filename);
+    ::close(fd);
+    return false;
+  }
+  if (st.st_size == 0) {
+    // Nothing to map. It is read as a file without puzzles.
+    ::close(fd);
+    return true;
+  }
+
+  void* data = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+  ::close(fd);
+  if (data == MAP_FAILED) {
+    perror(filename);
+    return false;
+  }
+
+  if (hasBankMagic((const uint8_t*)data, st.st_size)) {
+    munmap(data, st.st_size);
+    _format = PuzzleFormat::Bank;
+    return _bank.open(filename);
+  }
+
+  madvise(data, st.st_size, MADV_SEQUENTIAL);
+  _data = (const char*)data;
+  _size = st.st_size;
+
+  return true;
+}
+
+void PuzzleReader::close() {
+  if (_data != NULL) {
+    munmap((void*)_data, _size);
+    _data = NULL;
+  }
+  _bank.close();
+
+  _format = PuzzleFormat::Line;
+  _size = 0;
+  _pos = 0;
+  _nextEntry = 0;
+  _numRead = 0;
+  _failed = false;
+}
+
+bool PuzzleReader::nextLine(uint8_t* values) {
+  while (_pos < _size) {
+    const char* line = _data + _pos;
+    const char* end = (const char*)memchr(line, '\n', _size - _pos);
+    size_t len = (end != NULL) ? end - line : _size - _pos;
+    _pos += (end != NULL) ? len + 1 : len;
+
+    if (len == 0 || line[0] == '#' || line[0] == '\r') {
+      continue;
+    }
+
+    // The line may not be terminated, so check its length before parsing
+    _failed = len < (size_t)puzzleLineLen || !parsePuzzleValues(line, values);
+    return !_failed;
+  }
+
+  return false;
+}
+
+bool PuzzleReader::readValues(uint8_t* values, bool& hyper) {
+  if (_failed) {
+    return false;
+  }
+
+  if (_format == PuzzleFormat::Line) {
+    return nextLine(values);
+  }
+
+  if (_nextEntry == _bank.count()) {
+    return false;
+  }
+  hyper = _bank.read(_nextEntry++, values).hyper;
+  return true;
+}
+
+bool PuzzleReader::next(uint8_t* values) {
+  bool hyper;
+  if (!readValues(values, hyper)) {
+    return false;
+  }
+
+  _numRead++;
+  return true;
+}
+
+bool PuzzleReader::next(Sudoku& sudoku, bool hyperConstraints) {
+  uint8_t values[numCells];
+  bool hyper = hyperConstraints;
+  if (!readValues(values, hyper)) {
+    return false;
+  }
+
+  _failed = hyper != hyperConstraints || !sudoku.reset(hyperConstraints, values);
+  if (_failed) {
+    return false;
+  }
+
+  _numRead++;
+  return true;
+}
@@ -0,0 +1,81 @@
+/*
+ * Sudoku, a Gamebuino game
+ *
+ * Copyright 2018, Erwin Bonsma
+ */
+
+#ifndef __PUZZLE_READER_INCLUDED
+#define __PUZZLE_READER_INCLUDED
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "PuzzleBank.h"
+#include "Sudoku.h"
+
+enum class PuzzleFormat : int {
+  // One puzzle per line, see PuzzleIO.h
+  Line,
+  // A puzzle bank, see PuzzleBank.h
+  Bank
+};
+
+/* Reads the puzzles of a file one after another.
+ *
+ * The format is detected from the contents. The file is memory-mapped and
+ * puzzles are parsed from it in place, without first copying each line. They
+ * are converted to packed values (see Sudoku::reset), so that they can also
+ * be read without setting up a puzzle.
+ *
+ * Unlike reading from a stream (see readPuzzleLine), this requires a regular
+ * file.
+ */
+class PuzzleReader {
+  PuzzleFormat _format;
+
+  // The mapped file, for the line format
+  const char* _data;
+  size_t _size;
+  size_t _pos;
+
+  PuzzleBank _bank;
+  uint32_t _nextEntry;
+
+  int _numRead;
+  bool _failed;
+
+  bool nextLine(uint8_t* values);
+
+  // Reads the values of the next puzzle. For bank entries, it also sets their
+  // puzzle type.
+  bool readValues(uint8_t* values, bool& hyper);
+
+public:
+  PuzzleReader();
+  ~PuzzleReader();
+
+  // Opens the file. Returns false, after reporting why, when it fails.
+  bool open(const char* filename);
+  void close();
+
+  PuzzleFormat format() { return _format; }
+
+  /* Reads the values of the next puzzle. Empty lines and lines starting with
+   * a '#' are skipped. Returns false at the end of the file or when the
+   * puzzle is malformed, which failed() tells apart.
+   */
+  bool next(uint8_t* values);
+
+  /* Resets the puzzle to the next one. Besides the cases above, it also fails
+   * when a value violates one of the constraints, or when a bank entry is not
+   * of the given puzzle type.
+   */
+  bool next(Sudoku& sudoku, bool hyperConstraints);
+
+  // The number of puzzles that were read successfully
+  int numRead() { return _numRead; }
+
+  bool failed() { return _failed; }
+};
+
+#endif
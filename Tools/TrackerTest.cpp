@@ -0,0 +1,203 @@
+/*
+ * Sudoku, a Gamebuino game
+ *
+ * Copyright 2018, Erwin Bonsma
+ */
+
+/* Checks the solution tracker as the game uses it while a puzzle is edited.
+ *
+ * The tracker borrows the solver of the puzzle cache, which the game suspends
+ * each frame before stepping the tracker (see suspendPuzzleCache). This is
+ * replayed here for a series of edits of sparse puzzles, some of which are
+ * made before counting finished. It checks that each count finishes within a
+ * bounded number of frames, and that it agrees with a separate solver. It
+ * also checks that a search stops when its cancel flag is set.
+ *
+ * Usage: tracker-test [-n edits] [-s seed]
+ *   -n  Number of edits (default: 500)
+ *   -s  Seed for the random generators (default: 1)
+ */
+
+#include <atomic>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "PuzzleGenerator.h"
+#include "SolutionTracker.h"
+#include "Solver.h"
+#include "Stripper.h"
+#include "Sudoku.h"
+#include "Utils.h"
+
+// The time that the tracker may spend per frame. It is kept small, so that
+// counts span many frames.
+const uint32_t frameBudgetMicros = 1;
+
+// Counting stops after maxCountNodes, so it should always end well within
+// this number of frames
+const int maxFrames = 100000;
+
+// The puzzle cache, as in PuzzleCache.cpp
+Sudoku cacheSudoku;
+Solver cacheSolver(cacheSudoku);
+Stripper cacheStripper(cacheSudoku, cacheSolver);
+PuzzleGenerator cacheGenerator(cacheSudoku, cacheSolver, cacheStripper);
+
+Solver& suspendPuzzleCache() {
+  cacheGenerator.cancel();
+
+  return cacheSolver;
+}
+
+// The puzzle that is being edited, and the solver that checks the counts
+Sudoku sudoku;
+Sudoku refSudoku;
+Solver refSolver(refSudoku);
+
+Random editRandom;
+
+/* Sets the puzzle to a random part of a random solution, so that it has one
+ * or (when sparse) more solutions. It sets at most the given number of clues.
+ */
+void randomEdit(int numClues) {
+  refSudoku.reset(false);
+  assertTrue(refSolver.randomSolve());
+
+  sudoku.reset(false);
+  for (int i = 0; i < numClues; i++) {
+    int index = editRandom.next(numCells);
+    if (!sudoku.cellAt(index).isSet()) {
+      sudoku.setBitValue(sudoku.cellAt(index), refSudoku.cellAt(index).getBitValue());
+    }
+  }
+}
+
+SolutionCount referenceCount() {
+  refSudoku.reset(sudoku);
+  return refSolver.countSolutions();
+}
+
+/* Counts the solutions of a sparse puzzle with the cancel flag already set.
+ * The search should stop at its first node, and leave the puzzle as it was.
+ */
+bool checkCancelFlag() {
+  // Too few clues to solve it without search
+  randomEdit(10);
+  refSudoku.reset(sudoku);
+
+  std::atomic<bool> cancelled(true);
+  refSolver.setCancelFlag(&cancelled);
+  SolutionCount count = refSolver.countSolutions();
+  refSolver.setCancelFlag(NULL);
+
+  if (count != SolutionCount::Unknown || !refSolver.isExhausted()) {
+    fprintf(stderr, "Cancelled count ended with %d solutions\n", (int)count);
+    return false;
+  }
+  for (int i = 0; i < numCells; i++) {
+    if (refSudoku.cellAt(i).getBitValue() != sudoku.cellAt(i).getBitValue()) {
+      fprintf(stderr, "Cancelled count changed cell %d\n", i);
+      return false;
+    }
+  }
+
+  return true;
+}
+
+void usage(const char* name) {
+  fprintf(stderr, "Usage: %s [-n edits] [-s seed]\n", name);
+  exit(EXIT_FAILURE);
+}
+
+int main(int argc, char* argv[]) {
+  int numEdits = 500;
+  uint32_t seed = 1;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "n:s:")) != -1) {
+    switch (opt) {
+      case 'n': numEdits = atoi(optarg); break;
+      case 's': seed = (uint32_t)strtoul(optarg, NULL, 10); break;
+      default: usage(argv[0]);
+    }
+  }
+  if (optind != argc || numEdits < 1) {
+    usage(argv[0]);
+  }
+
+  sudoku.init();
+  refSudoku.init();
+  cacheSudoku.init();
+  editRandom.seed(seed);
+  refSolver.seedRandom(seed);
+  cacheSolver.seedRandom(seed + 1);
+
+  if (!checkCancelFlag()) {
+    return EXIT_FAILURE;
+  }
+
+  SolutionTracker tracker(sudoku);
+  int numCounted = 0;
+  int numUnknown = 0;
+  int numInterrupted = 0;
+  int numFailed = 0;
+  long totalFrames = 0;
+
+  for (int edit = 0; edit < numEdits; edit++) {
+    // The cache is typically generating a puzzle when the player edits
+    if (!cacheGenerator.isBusy()) {
+      cacheSolver.cancel();
+      cacheGenerator.start(false);
+    }
+    cacheGenerator.step(frameBudgetMicros);
+
+    randomEdit(editRandom.next(30));
+    if (tracker.puzzleChanged() != SolutionCount::Computing) {
+      continue;
+    }
+
+    // Sometimes edit again before counting finished
+    int interruptAt = (editRandom.next(4) == 0) ? editRandom.next(10) : -1;
+
+    int frame = 0;
+    bool done = false;
+    while (!done && frame < maxFrames) {
+      done = tracker.step(suspendPuzzleCache(), frameBudgetMicros);
+      frame++;
+      if (!done && frame == interruptAt) {
+        numInterrupted++;
+        break;
+      }
+    }
+    if (!done) {
+      if (frame == interruptAt) {
+        continue;
+      }
+      fprintf(stderr, "Edit %d: count did not finish in %d frames\n", edit, maxFrames);
+      numFailed++;
+      continue;
+    }
+
+    numCounted++;
+    totalFrames += frame;
+    SolutionCount count = tracker.solutionCount();
+    if (count == SolutionCount::Unknown) {
+      numUnknown++;
+    } else if (count != referenceCount()) {
+      fprintf(
+        stderr, "Edit %d: counted %d solutions, expected %d\n",
+        edit, (int)count, (int)referenceCount()
+      );
+      numFailed++;
+    }
+  }
+
+  printf(
+    "%d edits: %d counted (%d unknown), %d interrupted, %d failed, %.1f frames per count\n",
+    numEdits, numCounted, numUnknown, numInterrupted, numFailed,
+    numCounted > 0 ? (double)totalFrames / numCounted : 0.0
+  );
+
+  return (numFailed == 0) ? EXIT_SUCCESS : EXIT_FAILURE;
+}